@@ -58,9 +58,16 @@ uint8_t LastDiscrepancy;
 uint8_t LastFamilyDiscrepancy;
 bool LastDeviceFlag;
 
+// Updated from the bus owner and read by the diag task on the other core
+static ds18b20_stats_t busStats;
+// Power mode of the bus, from READPOWERSUPPLY; parasite until detected
+static bool parasite = true;
+static int64_t conversionStart;
+
 /// Sends one bit to bus
 void ds18b20_write(char bit)
 {
+    __atomic_fetch_add(&busStats.slots, 1, __ATOMIC_RELAXED);
     if (bit & 1)
     {
         gpio_set_direction(DS_GPIO, GPIO_MODE_OUTPUT);
@@ -83,9 +90,26 @@ void ds18b20_write(char bit)
     }
 }
 
+// Sends a command byte and drives the bus high right after its last slot
+// instead of releasing it: parasite powered sensors need the strong pull-up
+// within 10 us of a conversion command, sooner than write_byte returns
+static void write_byte_pullup(unsigned char data)
+{
+    for (int i = 0; i < 7; i++)
+        ds18b20_write((data >> i) & 0x01);
+    __atomic_fetch_add(&busStats.slots, 1, __ATOMIC_RELAXED);
+    gpio_set_direction(DS_GPIO, GPIO_MODE_OUTPUT);
+    noInterrupts();
+    gpio_set_level(DS_GPIO, 0);
+    ets_delay_us((data & 0x80) ? 6 : 60);
+    gpio_set_level(DS_GPIO, 1);
+    interrupts();
+}
+
 // Reads one bit from bus
 unsigned char ds18b20_read(void)
 {
+    __atomic_fetch_add(&busStats.slots, 1, __ATOMIC_RELAXED);
     unsigned char value = 0;
     gpio_set_direction(DS_GPIO, GPIO_MODE_OUTPUT);
     noInterrupts();
@@ -127,6 +151,7 @@ unsigned char ds18b20_read_byte(void)
 // Sends reset pulse
 unsigned char ds18b20_reset(void)
 {
+    __atomic_fetch_add(&busStats.resets, 1, __ATOMIC_RELAXED);
     unsigned char presence;
     gpio_set_direction(DS_GPIO, GPIO_MODE_OUTPUT);
     noInterrupts();
@@ -141,12 +166,29 @@ unsigned char ds18b20_reset(void)
     return presence;
 }
 
+// Configuration register value for a resolution in bits
+static uint8_t resolution_config(uint8_t resolution)
+{
+    switch (resolution)
+    {
+    case 12:
+        return TEMP_12_BIT;
+    case 11:
+        return TEMP_11_BIT;
+    case 10:
+        return TEMP_10_BIT;
+    case 9:
+    default:
+        return TEMP_9_BIT;
+    }
+}
+
 bool ds18b20_setResolution(const DeviceAddress tempSensorAddresses[], int numAddresses, uint8_t newResolution)
 {
-    bool success = false;
+    int updated = 0;
     // handle the sensors with configuration register
     newResolution = constrain(newResolution, 9, 12);
-    uint8_t newValue = 0;
+    uint8_t newValue = resolution_config(newResolution);
     ScratchPad scratchPad;
     // loop through each address
     for (int i = 0; i < numAddresses; i++)
@@ -154,22 +196,6 @@ bool ds18b20_setResolution(const DeviceAddress tempSensorAddresses[], int numAdd
         // we can only update the sensor if it is connected
         if (ds18b20_isConnected((DeviceAddress *)tempSensorAddresses[i], scratchPad))
         {
-            switch (newResolution)
-            {
-            case 12:
-                newValue = TEMP_12_BIT;
-                break;
-            case 11:
-                newValue = TEMP_11_BIT;
-                break;
-            case 10:
-                newValue = TEMP_10_BIT;
-                break;
-            case 9:
-            default:
-                newValue = TEMP_9_BIT;
-                break;
-            }
             // if it needs to be updated we write the new value
             if (scratchPad[CONFIGURATION] != newValue)
             {
@@ -177,10 +203,14 @@ bool ds18b20_setResolution(const DeviceAddress tempSensorAddresses[], int numAdd
                 ds18b20_writeScratchPad((DeviceAddress *)tempSensorAddresses[i], scratchPad);
             }
             // done
-            success = true;
+            updated++;
         }
     }
-    return success;
+    // millisToWaitForConversion() must cover every sensor of the bus: the
+    // wait only gets shorter when all of them took the new resolution
+    if (updated == numAddresses || newResolution > bitResolution)
+        bitResolution = newResolution;
+    return updated > 0;
 }
 
 void ds18b20_writeScratchPad(const DeviceAddress *deviceAddress, const uint8_t *scratchPad)
@@ -194,6 +224,21 @@ void ds18b20_writeScratchPad(const DeviceAddress *deviceAddress, const uint8_t *
     ds18b20_reset();
 }
 
+// Programs the alarm window in the scratchpad only: the EEPROM is left
+// alone, so a power cycle brings back the stored TH/TL. The configuration
+// register is rewritten with the current resolution.
+bool ds18b20_set_alarm_window(const DeviceAddress *deviceAddress, int8_t low, int8_t high)
+{
+    if (init != 1)
+        return false;
+    ScratchPad scratchPad = {0};
+    scratchPad[HIGH_ALARM_TEMP] = (uint8_t)high;
+    scratchPad[LOW_ALARM_TEMP] = (uint8_t)low;
+    scratchPad[CONFIGURATION] = resolution_config(bitResolution);
+    ds18b20_writeScratchPad(deviceAddress, scratchPad);
+    return true;
+}
+
 bool ds18b20_readScratchPad(const DeviceAddress *deviceAddress, uint8_t *scratchPad)
 {
     // send the reset command and fail fast
@@ -230,12 +275,8 @@ void ds18b20_select(const DeviceAddress *address)
 
 void ds18b20_requestTemperatures()
 {
-    ds18b20_reset();
-    ds18b20_write_byte(SKIPROM);
-    ds18b20_write_byte(GETTEMP);
-    unsigned long start = esp_timer_get_time() / 1000ULL;
-    while (!isConversionComplete() && ((esp_timer_get_time() / 1000ULL) - start < millisToWaitForConversion()))
-        vPortYield();
+    if (ds18b20_start_conversion())
+        ds18b20_wait_conversion();
 }
 
 bool isConversionComplete()
@@ -326,38 +367,135 @@ int16_t calculateTemperature(const DeviceAddress *deviceAddress, uint8_t *scratc
     return fpTemperature;
 }
 
-// Returns temperature from sensor
-float ds18b20_get_temp(void)
+// Asks every sensor whether it runs on parasite power. One parasite sensor
+// is enough for the whole bus to need the strong pull-up.
+bool ds18b20_detect_power(void)
 {
-    if (init == 1)
+    if (init != 1)
+        return false;
+    if (ds18b20_RST_PULSE() != 1)
+        return false;
+    ds18b20_send_byte(SKIPROM);
+    ds18b20_send_byte(READPOWERSUPPLY);
+    parasite = ds18b20_read() == 0; // parasite sensors pull the slot low
+    ds18b20_RST_PULSE();
+    return true;
+}
+
+bool ds18b20_is_parasite(void)
+{
+    return parasite;
+}
+
+// Starts a conversion on every sensor of the bus and returns at once; wait
+// for the result with ds18b20_wait_conversion(). On a parasite bus the pin
+// stays driven high until then, so nothing else may use the bus meanwhile.
+bool ds18b20_start_conversion(void)
+{
+    if (init != 1)
+        return false;
+    if (ds18b20_RST_PULSE() != 1)
+        return false;
+    ds18b20_send_byte(SKIPROM);
+    if (parasite)
+        write_byte_pullup(GETTEMP);
+    else
+        ds18b20_send_byte(GETTEMP);
+    conversionStart = esp_timer_get_time();
+    return true;
+}
+
+// Externally powered sensors answer read slots with 0 while converting, so
+// the bus is polled once per tick and the wait ends as soon as all of them
+// are done, usually well before the datasheet maximum. Parasite sensors
+// cannot answer while they feed from the strong pull-up: they get the full
+// millisToWaitForConversion() window, then the bus is released. Returns
+// false if powered sensors were still busy at the end of that window.
+bool ds18b20_wait_conversion(void)
+{
+    int64_t deadline = conversionStart + (int64_t)millisToWaitForConversion() * 1000;
+    if (!parasite)
     {
-        unsigned char check;
-        char temp1 = 0, temp2 = 0;
-        check = ds18b20_RST_PULSE();
-        if (check == 1)
+        while (!isConversionComplete())
         {
-            ds18b20_send_byte(0xCC);
-            ds18b20_send_byte(0x44);
-            vTaskDelay(750 / portTICK_PERIOD_MS);
-            check = ds18b20_RST_PULSE();
-            ds18b20_send_byte(0xCC);
-            ds18b20_send_byte(0xBE);
-            temp1 = ds18b20_read_byte();
-            temp2 = ds18b20_read_byte();
-            check = ds18b20_RST_PULSE();
-            float temp = 0;
-            temp = (float)(temp1 + (temp2 * 256)) / 16;
-            return temp;
-        }
-        else
-        {
-            return 0;
+            if (esp_timer_get_time() >= deadline)
+                return false;
+            vTaskDelay(1);
         }
+        return true;
+    }
+
+    int64_t left = deadline - esp_timer_get_time();
+    if (left > 0)
+    {
+        // Rounded up, plus one tick: the first one may be partial
+        TickType_t ticks = (left / 1000 + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS;
+        vTaskDelay(ticks + 1);
     }
+    gpio_set_direction(DS_GPIO, GPIO_MODE_INPUT);
+    return true;
+}
+
+// Reads the whole scratchpad after the ROM command and checks it. An
+// absent sensor leaves the bus high (all ones); a short or a collision
+// usually reads as zeros, which the CRC alone would accept.
+static ds18b20_status_t read_checked(const DeviceAddress *address, float *temp)
+{
+    if (init != 1)
+        return DS18B20_NO_DEVICE;
+    if (ds18b20_RST_PULSE() != 1)
+        return DS18B20_NO_DEVICE;
+    if (address != NULL)
+        ds18b20_select(address);
     else
+        ds18b20_send_byte(SKIPROM);
+    ds18b20_send_byte(READSCRATCH);
+    ScratchPad scratchPad;
+    bool allOnes = true;
+    for (int i = 0; i < 9; i++)
+    {
+        scratchPad[i] = ds18b20_read_byte();
+        allOnes = allOnes && scratchPad[i] == 0xFF;
+    }
+    ds18b20_RST_PULSE();
+    if (allOnes)
+        return DS18B20_NO_DEVICE;
+    if (ds18b20_isAllZeros(scratchPad) || ds18b20_crc8(scratchPad, 8) != scratchPad[SCRATCHPAD_CRC])
+        return DS18B20_CRC_ERROR;
+    // 12 bit two's complement, 1/16 C per step. Below 12 bits the low bits
+    // are undefined; the resolution comes from the sensor's own
+    // configuration byte, which may differ from bitResolution after a
+    // partial setResolution
+    int16_t raw = (int16_t)((scratchPad[TEMP_MSB] << 8) | scratchPad[TEMP_LSB]);
+    int undefinedBits = 3 - ((scratchPad[CONFIGURATION] >> 5) & 0x03);
+    raw &= ~((1 << undefinedBits) - 1);
+    *temp = (float)raw / 16;
+    return DS18B20_OK;
+}
+
+// Reads the result of the last conversion (single sensor bus)
+bool ds18b20_read_temp(float *temp)
+{
+    return read_checked(NULL, temp) == DS18B20_OK;
+}
+
+// Reads the result of the last conversion from one sensor of a shared bus
+ds18b20_status_t ds18b20_read_temp_rom(const DeviceAddress *address, float *temp)
+{
+    return read_checked(address, temp);
+}
+
+// Returns temperature from sensor, DEVICE_DISCONNECTED_C if it did not answer
+float ds18b20_get_temp(void)
+{
+    float temp = DEVICE_DISCONNECTED_C;
+    if (ds18b20_start_conversion())
     {
-        return 0;
+        ds18b20_wait_conversion();
+        if (!ds18b20_read_temp(&temp))
+            temp = DEVICE_DISCONNECTED_C;
     }
+    return temp;
 }
 
 void ds18b20_init(int GPIO)
@@ -365,6 +503,13 @@ void ds18b20_init(int GPIO)
     DS_GPIO = GPIO;
     esp_rom_gpio_pad_select_gpio(DS_GPIO);
     init = 1;
+    ds18b20_detect_power();
+}
+
+void ds18b20_get_stats(ds18b20_stats_t *stats)
+{
+    stats->resets = __atomic_load_n(&busStats.resets, __ATOMIC_RELAXED);
+    stats->slots = __atomic_load_n(&busStats.slots, __ATOMIC_RELAXED);
 }
 
 //
@@ -31,6 +31,21 @@
 typedef uint8_t DeviceAddress[8];
 typedef uint8_t ScratchPad[9];
 
+// Result of reading one sensor's scratchpad
+typedef enum
+{
+    DS18B20_OK,
+    DS18B20_NO_DEVICE, // no presence pulse, or nobody answered the ROM
+    DS18B20_CRC_ERROR, // scratchpad corrupted on the bus
+} ds18b20_status_t;
+
+// Bus activity counters: a reset takes ~960 us, a read or write slot ~70 us
+typedef struct
+{
+    uint32_t resets;
+    uint32_t slots;
+} ds18b20_stats_t;
+
 // Dow-CRC using polynomial X^8 + X^5 + X^4 + X^0
 // Tiny 2x16 entry CRC table created by Arjen Lentz
 // See http://lentz.com.au/blog/calculating-crc-with-a-tiny-32-entry-lookup-table
@@ -59,9 +74,13 @@ extern "C"
     unsigned char ds18b20_read_byte(void);
     unsigned char ds18b20_reset(void);
 
+    // Also sets the resolution used by millisToWaitForConversion()
     bool ds18b20_setResolution(const DeviceAddress tempSensorAddresses[], int numAddresses, uint8_t newResolution);
     bool ds18b20_isConnected(const DeviceAddress *deviceAddress, uint8_t *scratchPad);
     void ds18b20_writeScratchPad(const DeviceAddress *deviceAddress, const uint8_t *scratchPad);
+    // After a conversion the sensor flags an alarm when the whole degrees
+    // of the reading are <= low or >= high; see search(addr, false)
+    bool ds18b20_set_alarm_window(const DeviceAddress *deviceAddress, int8_t low, int8_t high);
     bool ds18b20_readScratchPad(const DeviceAddress *deviceAddress, uint8_t *scratchPad);
     void ds18b20_select(const DeviceAddress *address);
     uint8_t ds18b20_crc8(const uint8_t *addr, uint8_t len);
@@ -74,6 +93,14 @@ extern "C"
     float ds18b20_getTempC(const DeviceAddress *deviceAddress);
     int16_t calculateTemperature(const DeviceAddress *deviceAddress, uint8_t *scratchPad);
     float ds18b20_get_temp(void);
+    bool ds18b20_detect_power(void);
+    bool ds18b20_is_parasite(void);
+    bool ds18b20_start_conversion(void);
+    bool ds18b20_wait_conversion(void);
+    bool ds18b20_read_temp(float *temp);
+    ds18b20_status_t ds18b20_read_temp_rom(const DeviceAddress *address, float *temp);
+
+    void ds18b20_get_stats(ds18b20_stats_t *stats);
 
     void reset_search();
     bool search(uint8_t *newAddr, bool search_mode);
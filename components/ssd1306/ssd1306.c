@@ -18,6 +18,21 @@ typedef union out_column_t
 	uint8_t u8[4];
 } PACK8 out_column_t;
 
+// Updated from whichever core drives the panel and read by the diag task
+static ssd1306_stats_t busStats;
+
+void ssd1306_count_transaction(uint32_t bytes)
+{
+	__atomic_fetch_add(&busStats.transactions, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&busStats.bytes, bytes, __ATOMIC_RELAXED);
+}
+
+void ssd1306_get_stats(ssd1306_stats_t *stats)
+{
+	stats->transactions = __atomic_load_n(&busStats.transactions, __ATOMIC_RELAXED);
+	stats->bytes = __atomic_load_n(&busStats.bytes, __ATOMIC_RELAXED);
+}
+
 void ssd1306_init(SSD1306_t *dev, int width, int height)
 {
 	if (dev->_address == SPIAddress)
@@ -28,6 +43,8 @@ void ssd1306_init(SSD1306_t *dev, int width, int height)
 	{
 		i2c_init(dev, width, height);
 	}
+	dev->_tkEnable = false;
+	dev->_tkTop = 0;
 	// Initialize internal buffer
 	for (int i = 0; i < dev->_pages; i++)
 	{
@@ -131,6 +148,32 @@ void ssd1306_display_text(SSD1306_t *dev, int page, char *text, int text_len, bo
 	}
 }
 
+// Draw text starting at character column col with a single transfer.
+// Used to redraw only the part of a line that changed.
+void ssd1306_display_text_at(SSD1306_t *dev, int page, int col, char *text, int text_len, bool invert)
+{
+	if (page >= dev->_pages)
+		return;
+	if (col < 0 || col >= 16)
+		return;
+	int _text_len = text_len;
+	if (_text_len > 16 - col)
+		_text_len = 16 - col;
+	if (_text_len <= 0)
+		return;
+
+	uint8_t image[128];
+	for (int i = 0; i < _text_len; i++)
+	{
+		memcpy(&image[i * 8], font8x8_basic_tr[(uint8_t)text[i]], 8);
+	}
+	if (invert)
+		ssd1306_invert(image, _text_len * 8);
+	if (dev->_flip)
+		ssd1306_flip(image, _text_len * 8);
+	ssd1306_display_image(dev, page, col * 8, image, _text_len * 8);
+}
+
 // by Coert Vonk
 void ssd1306_display_text_x3(SSD1306_t *dev, int page, char *text, int text_len, bool invert)
 {
@@ -226,6 +269,19 @@ void ssd1306_contrast(SSD1306_t *dev, int contrast)
 	}
 }
 
+// Sleep mode: the panel is dark but GDDRAM keeps its content
+void ssd1306_display_power(SSD1306_t *dev, bool on)
+{
+	if (dev->_address == SPIAddress)
+	{
+		spi_display_power(dev, on);
+	}
+	else
+	{
+		i2c_display_power(dev, on);
+	}
+}
+
 void ssd1306_software_scroll(SSD1306_t *dev, int start, int end)
 {
 	ESP_LOGD(TAG, "software_scroll start=%d end=%d _pages=%d", start, end, dev->_pages);
@@ -316,6 +372,117 @@ void ssd1306_hardware_scroll(SSD1306_t *dev, ssd1306_scroll_type_t scroll)
 	}
 }
 
+void ssd1306_display_start_line(SSD1306_t *dev, int line)
+{
+	if (dev->_address == SPIAddress)
+	{
+		spi_display_start_line(dev, line);
+	}
+	else
+	{
+		i2c_display_start_line(dev, line);
+	}
+}
+
+// Ticker: a line log that scrolls by moving the display start line.
+// GDDRAM is used as a circular buffer of 8 pages. Each new line costs one page
+// write plus one command byte, the rest of the screen is never resent.
+// While the ticker runs, dev->_page[] is indexed by GDDRAM page, not by screen line.
+static void ssd1306_ticker_send(SSD1306_t *dev, int ram_page)
+{
+	if (dev->_address == SPIAddress)
+	{
+		spi_display_ram(dev, ram_page, 0, dev->_page[ram_page]._segs, dev->_width);
+	}
+	else
+	{
+		i2c_display_ram(dev, ram_page, 0, dev->_page[ram_page]._segs, dev->_width);
+	}
+}
+
+void ssd1306_ticker_init(SSD1306_t *dev)
+{
+	dev->_tkEnable = true;
+	dev->_tkTop = 0;
+	ssd1306_display_start_line(dev, 0);
+	// Hidden pages (128x32 panel) come into view later, so clear all of them once
+	for (int page = 0; page < SSD1306_RAM_PAGES; page++)
+	{
+		memset(dev->_page[page]._segs, 0, 128);
+		ssd1306_ticker_send(dev, page);
+	}
+}
+
+void ssd1306_ticker_text(SSD1306_t *dev, char *text, int text_len, bool invert)
+{
+	if (dev->_tkEnable == false)
+		return;
+
+	// Without flip the screen shows pages _tkTop.._tkTop+_pages-1 from top to bottom,
+	// so the new line goes right below the window and the window moves one page down.
+	// With flip the screen is upside down and the window moves the other way.
+	int top;
+	int page;
+	if (dev->_flip)
+	{
+		top = (dev->_tkTop + SSD1306_RAM_PAGES - 1) % SSD1306_RAM_PAGES;
+		page = top;
+	}
+	else
+	{
+		top = (dev->_tkTop + 1) % SSD1306_RAM_PAGES;
+		page = (dev->_tkTop + dev->_pages) % SSD1306_RAM_PAGES;
+	}
+	ESP_LOGD(TAG, "ticker top=%d page=%d", top, page);
+
+	int _text_len = text_len;
+	if (_text_len > 16)
+		_text_len = 16;
+
+	uint8_t *segs = dev->_page[page]._segs;
+	memset(segs, 0, 128);
+	for (int i = 0; i < _text_len; i++)
+	{
+		memcpy(&segs[i * 8], font8x8_basic_tr[(uint8_t)text[i]], 8);
+	}
+	if (invert)
+		ssd1306_invert(segs, 128);
+	if (dev->_flip)
+		ssd1306_flip(segs, 128);
+
+	// A page outside the window can be written before it shows up.
+	// On a 64 line panel the page is the oldest visible line, so move first.
+	bool hidden = dev->_pages < SSD1306_RAM_PAGES;
+	if (hidden)
+		ssd1306_ticker_send(dev, page);
+	ssd1306_display_start_line(dev, top * 8);
+	if (!hidden)
+		ssd1306_ticker_send(dev, page);
+	dev->_tkTop = top;
+}
+
+// Back to normal addressing: rotate the buffer into screen order and redraw once.
+void ssd1306_ticker_stop(SSD1306_t *dev)
+{
+	if (dev->_tkEnable == false)
+		return;
+
+	PAGE_t ram[SSD1306_RAM_PAGES];
+	memcpy(ram, dev->_page, sizeof(ram));
+	for (int page = 0; page < dev->_pages; page++)
+	{
+		// GDDRAM page shown on this line, the transports apply the flip mapping again
+		int line = page;
+		if (dev->_flip)
+			line = (dev->_pages - page) - 1;
+		dev->_page[page] = ram[(dev->_tkTop + line) % SSD1306_RAM_PAGES];
+	}
+	dev->_tkEnable = false;
+	dev->_tkTop = 0;
+	ssd1306_display_start_line(dev, 0);
+	ssd1306_show_buffer(dev);
+}
+
 // delay = 0 : display with no wait
 // delay > 0 : display with wait
 // delay < 0 : no display
@@ -68,6 +68,9 @@ Usage:
 #define OLED_CMD_ACTIVE_SCROLL 0x2F
 #define OLED_CMD_VERTICAL 0xA3
 
+// GDDRAM always has 8 pages, even when the panel shows only 4 of them
+#define SSD1306_RAM_PAGES 8
+
 #define I2CAddress 0x3C
 #define SPIAddress 0xFF
 
@@ -101,8 +104,17 @@ typedef struct
 	int _scDirection;
 	PAGE_t _page[8];
 	bool _flip;
+	bool _tkEnable;
+	int _tkTop; // GDDRAM page at the top of the panel while the ticker runs
 } SSD1306_t;
 
+// Bus traffic counters, shared by both transports
+typedef struct
+{
+	uint32_t transactions;
+	uint32_t bytes;
+} ssd1306_stats_t;
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -117,14 +129,20 @@ extern "C"
 	void ssd1306_get_buffer(SSD1306_t *dev, uint8_t *buffer);
 	void ssd1306_display_image(SSD1306_t *dev, int page, int seg, uint8_t *images, int width);
 	void ssd1306_display_text(SSD1306_t *dev, int page, char *text, int text_len, bool invert);
+	void ssd1306_display_text_at(SSD1306_t *dev, int page, int col, char *text, int text_len, bool invert);
 	void ssd1306_display_text_x3(SSD1306_t *dev, int page, char *text, int text_len, bool invert);
 	void ssd1306_clear_screen(SSD1306_t *dev, bool invert);
 	void ssd1306_clear_line(SSD1306_t *dev, int page, bool invert);
 	void ssd1306_contrast(SSD1306_t *dev, int contrast);
+	void ssd1306_display_power(SSD1306_t *dev, bool on);
 	void ssd1306_software_scroll(SSD1306_t *dev, int start, int end);
 	void ssd1306_scroll_text(SSD1306_t *dev, char *text, int text_len, bool invert);
 	void ssd1306_scroll_clear(SSD1306_t *dev);
 	void ssd1306_hardware_scroll(SSD1306_t *dev, ssd1306_scroll_type_t scroll);
+	void ssd1306_display_start_line(SSD1306_t *dev, int line);
+	void ssd1306_ticker_init(SSD1306_t *dev);
+	void ssd1306_ticker_text(SSD1306_t *dev, char *text, int text_len, bool invert);
+	void ssd1306_ticker_stop(SSD1306_t *dev);
 	void ssd1306_wrap_arround(SSD1306_t *dev, ssd1306_scroll_type_t scroll, int start, int end, int8_t delay);
 	void ssd1306_bitmaps(SSD1306_t *dev, int xpos, int ypos, uint8_t *bitmap, int width, int height, bool invert);
 	void _ssd1306_pixel(SSD1306_t *dev, int xpos, int ypos, bool invert);
@@ -140,7 +158,10 @@ extern "C"
 	void i2c_master_init(SSD1306_t *dev, int16_t sda, int16_t scl, int16_t reset);
 	void i2c_init(SSD1306_t *dev, int width, int height);
 	void i2c_display_image(SSD1306_t *dev, int page, int seg, uint8_t *images, int width);
+	void i2c_display_ram(SSD1306_t *dev, int ram_page, int seg, uint8_t *images, int width);
+	void i2c_display_start_line(SSD1306_t *dev, int line);
 	void i2c_contrast(SSD1306_t *dev, int contrast);
+	void i2c_display_power(SSD1306_t *dev, bool on);
 	void i2c_hardware_scroll(SSD1306_t *dev, ssd1306_scroll_type_t scroll);
 
 	void spi_master_init(SSD1306_t *dev, int16_t GPIO_MOSI, int16_t GPIO_SCLK, int16_t GPIO_CS, int16_t GPIO_DC, int16_t GPIO_RESET);
@@ -149,9 +170,16 @@ extern "C"
 	bool spi_master_write_data(SSD1306_t *dev, const uint8_t *Data, size_t DataLength);
 	void spi_init(SSD1306_t *dev, int width, int height);
 	void spi_display_image(SSD1306_t *dev, int page, int seg, uint8_t *images, int width);
+	void spi_display_ram(SSD1306_t *dev, int ram_page, int seg, uint8_t *images, int width);
+	void spi_display_start_line(SSD1306_t *dev, int line);
 	void spi_contrast(SSD1306_t *dev, int contrast);
+	void spi_display_power(SSD1306_t *dev, bool on);
 	void spi_hardware_scroll(SSD1306_t *dev, ssd1306_scroll_type_t scroll);
 
+	void ssd1306_get_stats(ssd1306_stats_t *stats);
+	// Called by the transports once per bus transaction
+	void ssd1306_count_transaction(uint32_t bytes);
+
 	void setup_display_text(SSD1306_t *dev);
 
 #ifdef __cplusplus
@@ -7,6 +7,7 @@
 #include "esp_log.h"
 
 #include "ssd1306.h"
+#include "trace.h"
 
 #define tag "SSD1306"
 
@@ -98,24 +99,35 @@ void i2c_init(SSD1306_t * dev, int width, int height) {
 		ESP_LOGE(tag, "OLED configuration failed. code: 0x%.2X", espRc);
 	}
 	i2c_cmd_link_delete(cmd);
+	ssd1306_count_transaction(2 + 26); // address, control byte and 26 command bytes
 }
 
 
 void i2c_display_image(SSD1306_t * dev, int page, int seg, uint8_t * images, int width) {
-	i2c_cmd_handle_t cmd;
-
 	if (page >= dev->_pages) return;
 	if (seg >= dev->_width) return;
 
-	int _seg = seg + CONFIG_OFFSETX;
-	uint8_t columLow = _seg & 0x0F;
-	uint8_t columHigh = (_seg >> 4) & 0x0F;
-
 	int _page = page;
 	if (dev->_flip) {
 		_page = (dev->_pages - page) - 1;
 	}
 
+	i2c_display_ram(dev, _page, seg, images, width);
+}
+
+// Write to a GDDRAM page as is, without flip mapping.
+// Pages beyond dev->_pages are valid here: the controller always has 8 of them.
+void i2c_display_ram(SSD1306_t * dev, int ram_page, int seg, uint8_t * images, int width) {
+	i2c_cmd_handle_t cmd;
+
+	if (ram_page >= SSD1306_RAM_PAGES) return;
+	if (seg >= dev->_width) return;
+
+	TRACE_BEGIN(TRACE_SSD1306_XFER, width);
+	int _seg = seg + CONFIG_OFFSETX;
+	uint8_t columLow = _seg & 0x0F;
+	uint8_t columHigh = (_seg >> 4) & 0x0F;
+
 	cmd = i2c_cmd_link_create();
 	i2c_master_start(cmd);
 	i2c_master_write_byte(cmd, (dev->_address << 1) | I2C_MASTER_WRITE, true);
@@ -126,11 +138,12 @@ void i2c_display_image(SSD1306_t * dev, int page, int seg, uint8_t * images, int
 	// Set Higher Column Start Address for Page Addressing Mode
 	i2c_master_write_byte(cmd, (0x10 + columHigh), true);
 	// Set Page Start Address for Page Addressing Mode
-	i2c_master_write_byte(cmd, 0xB0 | _page, true);
+	i2c_master_write_byte(cmd, 0xB0 | ram_page, true);
 
 	i2c_master_stop(cmd);
 	i2c_master_cmd_begin(I2C_NUM, cmd, 10/portTICK_PERIOD_MS);
 	i2c_cmd_link_delete(cmd);
+	ssd1306_count_transaction(5);
 
 	cmd = i2c_cmd_link_create();
 	i2c_master_start(cmd);
@@ -142,6 +155,8 @@ void i2c_display_image(SSD1306_t * dev, int page, int seg, uint8_t * images, int
 	i2c_master_stop(cmd);
 	i2c_master_cmd_begin(I2C_NUM, cmd, 10/portTICK_PERIOD_MS);
 	i2c_cmd_link_delete(cmd);
+	ssd1306_count_transaction(2 + width);
+	TRACE_END(TRACE_SSD1306_XFER, width);
 }
 
 void i2c_contrast(SSD1306_t * dev, int contrast) {
@@ -159,11 +174,42 @@ void i2c_contrast(SSD1306_t * dev, int contrast) {
 	i2c_master_stop(cmd);
 	i2c_master_cmd_begin(I2C_NUM, cmd, 10/portTICK_PERIOD_MS);
 	i2c_cmd_link_delete(cmd);
+	ssd1306_count_transaction(4);
 }
 
+void i2c_display_power(SSD1306_t * dev, bool on) {
+	TRACE_INSTANT(TRACE_SSD1306_COMMAND, on ? OLED_CMD_DISPLAY_ON : OLED_CMD_DISPLAY_OFF);
+	i2c_cmd_handle_t cmd;
+
+	cmd = i2c_cmd_link_create();
+	i2c_master_start(cmd);
+	i2c_master_write_byte(cmd, (dev->_address << 1) | I2C_MASTER_WRITE, true);
+	i2c_master_write_byte(cmd, OLED_CONTROL_BYTE_CMD_SINGLE, true);
+	i2c_master_write_byte(cmd, on ? OLED_CMD_DISPLAY_ON : OLED_CMD_DISPLAY_OFF, true);	// AF / AE
+	i2c_master_stop(cmd);
+	i2c_master_cmd_begin(I2C_NUM, cmd, 10/portTICK_PERIOD_MS);
+	i2c_cmd_link_delete(cmd);
+	ssd1306_count_transaction(3);
+}
+
+void i2c_display_start_line(SSD1306_t * dev, int line) {
+	TRACE_INSTANT(TRACE_SSD1306_COMMAND, OLED_CMD_SET_DISPLAY_START_LINE | (line & 0x3F));
+	i2c_cmd_handle_t cmd;
+
+	cmd = i2c_cmd_link_create();
+	i2c_master_start(cmd);
+	i2c_master_write_byte(cmd, (dev->_address << 1) | I2C_MASTER_WRITE, true);
+	i2c_master_write_byte(cmd, OLED_CONTROL_BYTE_CMD_SINGLE, true);
+	i2c_master_write_byte(cmd, OLED_CMD_SET_DISPLAY_START_LINE | (line & 0x3F), true);	// 40-7F
+	i2c_master_stop(cmd);
+	i2c_master_cmd_begin(I2C_NUM, cmd, 10/portTICK_PERIOD_MS);
+	i2c_cmd_link_delete(cmd);
+	ssd1306_count_transaction(3);
+}
 
 void i2c_hardware_scroll(SSD1306_t * dev, ssd1306_scroll_type_t scroll) {
 	esp_err_t espRc;
+	int commands = 0;
 
 	i2c_cmd_handle_t cmd = i2c_cmd_link_create();
 	i2c_master_start(cmd);
@@ -180,6 +226,7 @@ void i2c_hardware_scroll(SSD1306_t * dev, ssd1306_scroll_type_t scroll) {
 		i2c_master_write_byte(cmd, 0x00, true); //
 		i2c_master_write_byte(cmd, 0xFF, true); //
 		i2c_master_write_byte(cmd, OLED_CMD_ACTIVE_SCROLL, true);		// 2F
+		commands = 8;
 	} 
 
 	if (scroll == SCROLL_LEFT) {
@@ -191,6 +238,7 @@ void i2c_hardware_scroll(SSD1306_t * dev, ssd1306_scroll_type_t scroll) {
 		i2c_master_write_byte(cmd, 0x00, true); //
 		i2c_master_write_byte(cmd, 0xFF, true); //
 		i2c_master_write_byte(cmd, OLED_CMD_ACTIVE_SCROLL, true);		// 2F
+		commands = 8;
 	} 
 
 	if (scroll == SCROLL_DOWN) {
@@ -210,6 +258,7 @@ void i2c_hardware_scroll(SSD1306_t * dev, ssd1306_scroll_type_t scroll) {
 		if (dev->_height == 32)
 		i2c_master_write_byte(cmd, 0x20, true);
 		i2c_master_write_byte(cmd, OLED_CMD_ACTIVE_SCROLL, true);		// 2F
+		commands = 10;
 	}
 
 	if (scroll == SCROLL_UP) {
@@ -229,10 +278,12 @@ void i2c_hardware_scroll(SSD1306_t * dev, ssd1306_scroll_type_t scroll) {
 		if (dev->_height == 32)
 		i2c_master_write_byte(cmd, 0x20, true);
 		i2c_master_write_byte(cmd, OLED_CMD_ACTIVE_SCROLL, true);		// 2F
+		commands = 10;
 	}
 
 	if (scroll == SCROLL_STOP) {
 		i2c_master_write_byte(cmd, OLED_CMD_DEACTIVE_SCROLL, true);		// 2E
+		commands = 1;
 	}
 
 	i2c_master_stop(cmd);
@@ -244,5 +295,6 @@ void i2c_hardware_scroll(SSD1306_t * dev, ssd1306_scroll_type_t scroll) {
 	}
 
 	i2c_cmd_link_delete(cmd);
+	ssd1306_count_transaction(2 + commands);
 }
 
@@ -8,6 +8,7 @@
 #include "esp_log.h"
 
 #include "ssd1306.h"
+#include "trace.h"
 
 #define TAG "SSD1306"
 
@@ -87,6 +88,7 @@ bool spi_master_write_byte(spi_device_handle_t SPIHandle, const uint8_t* Data, s
 		SPITransaction.length = DataLength * 8;
 		SPITransaction.tx_buffer = Data;
 		spi_device_transmit( SPIHandle, &SPITransaction );
+		ssd1306_count_transaction(DataLength);
 	}
 
 	return true;
@@ -158,24 +160,35 @@ void spi_display_image(SSD1306_t * dev, int page, int seg, uint8_t * images, int
 	if (page >= dev->_pages) return;
 	if (seg >= dev->_width) return;
 
-	int _seg = seg + CONFIG_OFFSETX;
-	uint8_t columLow = _seg & 0x0F;
-	uint8_t columHigh = (_seg >> 4) & 0x0F;
-
 	int _page = page;
 	if (dev->_flip) {
 		_page = (dev->_pages - page) - 1;
 	}
 
+	spi_display_ram(dev, _page, seg, images, width);
+}
+
+// Write to a GDDRAM page as is, without flip mapping.
+// Pages beyond dev->_pages are valid here: the controller always has 8 of them.
+void spi_display_ram(SSD1306_t * dev, int ram_page, int seg, uint8_t * images, int width)
+{
+	if (ram_page >= SSD1306_RAM_PAGES) return;
+	if (seg >= dev->_width) return;
+
+	TRACE_BEGIN(TRACE_SSD1306_XFER, width);
+	int _seg = seg + CONFIG_OFFSETX;
+	uint8_t columLow = _seg & 0x0F;
+	uint8_t columHigh = (_seg >> 4) & 0x0F;
+
 	// Set Lower Column Start Address for Page Addressing Mode
 	spi_master_write_command(dev, (0x00 + columLow));
 	// Set Higher Column Start Address for Page Addressing Mode
 	spi_master_write_command(dev, (0x10 + columHigh));
 	// Set Page Start Address for Page Addressing Mode
-	spi_master_write_command(dev, 0xB0 | _page);
+	spi_master_write_command(dev, 0xB0 | ram_page);
 
 	spi_master_write_data(dev, images, width);
-
+	TRACE_END(TRACE_SSD1306_XFER, width);
 }
 
 void spi_contrast(SSD1306_t * dev, int contrast) {
@@ -187,6 +200,18 @@ void spi_contrast(SSD1306_t * dev, int contrast) {
 	spi_master_write_command(dev, _contrast);
 }
 
+void spi_display_power(SSD1306_t * dev, bool on)
+{
+	TRACE_INSTANT(TRACE_SSD1306_COMMAND, on ? OLED_CMD_DISPLAY_ON : OLED_CMD_DISPLAY_OFF);
+	spi_master_write_command(dev, on ? OLED_CMD_DISPLAY_ON : OLED_CMD_DISPLAY_OFF);	// AF / AE
+}
+
+void spi_display_start_line(SSD1306_t * dev, int line)
+{
+	TRACE_INSTANT(TRACE_SSD1306_COMMAND, OLED_CMD_SET_DISPLAY_START_LINE | (line & 0x3F));
+	spi_master_write_command(dev, OLED_CMD_SET_DISPLAY_START_LINE | (line & 0x3F));	// 40-7F
+}
+
 void spi_hardware_scroll(SSD1306_t * dev, ssd1306_scroll_type_t scroll)
 {
 
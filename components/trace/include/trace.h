@@ -0,0 +1,53 @@
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <stdint.h>
+
+// Event ids. The high bit marks the end of a span started with the same id,
+// the next one an instant event with no duration.
+#define TRACE_SPAN_END 0x8000
+#define TRACE_POINT 0x4000
+
+typedef enum
+{
+	TRACE_HCSR04_MEASURE = 1, // arg at the end: echo pulse in us, 0 if lost
+	TRACE_DS18B20_READ,       // arg at the end: temperature in 1/100 C
+	TRACE_DISPLAY_UPDATE,
+	TRACE_SSD1306_XFER,       // arg: bytes of image data
+	TRACE_SSD1306_COMMAND,    // arg: command byte
+	TRACE_BUTTON_ISR,         // arg: button pin
+	TRACE_ID_MAX
+} trace_id_t;
+
+typedef struct
+{
+	uint32_t ts; // esp_timer_get_time(), low 32 bits
+	uint16_t id;
+	uint16_t arg;
+} trace_event_t;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+	void trace_init(void);
+	void trace_record(uint16_t id, uint16_t arg);
+	void trace_dump(void);
+	uint32_t trace_read(int core, uint32_t *cursor, trace_event_t *events, uint32_t max, uint32_t *lost);
+
+#ifdef __cplusplus
+}
+#endif
+
+#if CONFIG_TRACE_ENABLE
+#define TRACE_BEGIN(id, arg) trace_record((id), (uint16_t)(arg))
+#define TRACE_END(id, arg) trace_record((id) | TRACE_SPAN_END, (uint16_t)(arg))
+#define TRACE_INSTANT(id, arg) trace_record((id) | TRACE_POINT, (uint16_t)(arg))
+#else
+#define TRACE_BEGIN(id, arg) ((void)0)
+#define TRACE_END(id, arg) ((void)0)
+#define TRACE_INSTANT(id, arg) ((void)0)
+#endif
+
+#endif /* TRACE_H_ */
@@ -0,0 +1,148 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "trace.h"
+
+#define TAG "TRACE"
+
+#if CONFIG_TRACE_ENABLE
+
+#define TRACE_MASK (CONFIG_TRACE_BUFFER_EVENTS - 1)
+
+_Static_assert((CONFIG_TRACE_BUFFER_EVENTS & TRACE_MASK) == 0, "CONFIG_TRACE_BUFFER_EVENTS must be a power of two");
+
+// One ring per core: a core only ever writes its own ring, so no lock is needed.
+// Masking interrupts keeps an ISR from interleaving with a task on the same core.
+typedef struct
+{
+	volatile uint32_t head;
+	trace_event_t events[CONFIG_TRACE_BUFFER_EVENTS];
+} trace_ring_t;
+
+static DRAM_ATTR trace_ring_t rings[portNUM_PROCESSORS];
+
+static const char *trace_names[TRACE_ID_MAX] = {
+	[TRACE_HCSR04_MEASURE] = "hcsr04_measure",
+	[TRACE_DS18B20_READ] = "ds18b20_read",
+	[TRACE_DISPLAY_UPDATE] = "display_update",
+	[TRACE_SSD1306_XFER] = "ssd1306_xfer",
+	[TRACE_SSD1306_COMMAND] = "ssd1306_command",
+	[TRACE_BUTTON_ISR] = "button_isr",
+};
+
+void IRAM_ATTR trace_record(uint16_t id, uint16_t arg)
+{
+	unsigned state = portSET_INTERRUPT_MASK_FROM_ISR();
+	trace_ring_t *ring = &rings[xPortGetCoreID()];
+	uint32_t head = ring->head;
+	trace_event_t *event = &ring->events[head & TRACE_MASK];
+	event->ts = (uint32_t)esp_timer_get_time();
+	event->id = id;
+	event->arg = arg;
+	ring->head = head + 1;
+	portCLEAR_INTERRUPT_MASK_FROM_ISR(state);
+}
+
+// Dump format, one record per line, numbers in hex:
+//   TRACE NAME <id> <name>
+//   TRACE EV <core> <ts> <id> <arg>
+// Events recorded while dumping may overwrite the oldest entries, those are skipped.
+void trace_dump(void)
+{
+	printf("TRACE BEGIN\n");
+	for (int id = 1; id < TRACE_ID_MAX; id++)
+	{
+		printf("TRACE NAME %x %s\n", id, trace_names[id]);
+	}
+	for (int core = 0; core < portNUM_PROCESSORS; core++)
+	{
+		trace_ring_t *ring = &rings[core];
+		uint32_t head = ring->head;
+		uint32_t tail = head > CONFIG_TRACE_BUFFER_EVENTS ? head - CONFIG_TRACE_BUFFER_EVENTS : 0;
+		for (uint32_t i = tail; i != head; i++)
+		{
+			trace_event_t event = ring->events[i & TRACE_MASK];
+			// Overwritten in the meantime
+			if (ring->head - i > CONFIG_TRACE_BUFFER_EVENTS)
+				continue;
+			printf("TRACE EV %x %x %x %x\n", core, (unsigned)event.ts, event.id, event.arg);
+		}
+	}
+	printf("TRACE END\n");
+}
+
+// Incremental reader for streaming consumers. *cursor is the caller's position in
+// the ring of the given core (start at 0); events overwritten before they were
+// read are skipped and added to *lost. Returns the number of events copied.
+uint32_t trace_read(int core, uint32_t *cursor, trace_event_t *events, uint32_t max, uint32_t *lost)
+{
+	trace_ring_t *ring = &rings[core];
+	uint32_t head = ring->head;
+	uint32_t i = *cursor;
+	uint32_t count = 0;
+	if (head - i > CONFIG_TRACE_BUFFER_EVENTS)
+	{
+		*lost += head - i - CONFIG_TRACE_BUFFER_EVENTS;
+		i = head - CONFIG_TRACE_BUFFER_EVENTS;
+	}
+	for (; i != head && count < max; i++)
+	{
+		events[count] = ring->events[i & TRACE_MASK];
+		if (ring->head - i > CONFIG_TRACE_BUFFER_EVENTS)
+		{
+			(*lost)++;
+			continue;
+		}
+		count++;
+	}
+	*cursor = i;
+	return count;
+}
+
+#if CONFIG_TRACE_AUTODUMP_S > 0
+static void trace_dump_task(void *pvParams)
+{
+	for (;;)
+	{
+		vTaskDelay(pdMS_TO_TICKS(CONFIG_TRACE_AUTODUMP_S * 1000));
+		trace_dump();
+	}
+}
+#endif
+
+void trace_init(void)
+{
+	memset(rings, 0, sizeof(rings));
+	ESP_LOGI(TAG, "%d events per core", CONFIG_TRACE_BUFFER_EVENTS);
+#if CONFIG_TRACE_AUTODUMP_S > 0
+	xTaskCreate(&trace_dump_task, "trace_dump", 3072, NULL, 1, NULL);
+#endif
+}
+
+#else
+
+void trace_init(void)
+{
+}
+
+void trace_record(uint16_t id, uint16_t arg)
+{
+}
+
+void trace_dump(void)
+{
+	ESP_LOGW(TAG, "tracing disabled (CONFIG_TRACE_ENABLE)");
+}
+
+uint32_t trace_read(int core, uint32_t *cursor, trace_event_t *events, uint32_t max, uint32_t *lost)
+{
+	return 0;
+}
+
+#endif
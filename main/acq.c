@@ -0,0 +1,303 @@
+#include <math.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+#include <esp_log.h>
+#include "acq.h"
+#include "ranging.h"
+#include "hcsr04.h"
+#include "ds18b20.h"
+#include "trace.h"
+#include "power.h"
+
+#define ACQ_TAG "ACQ"
+// Faixa plausivel da agua. O DS18B20 liga com 85 C no scratchpad: uma
+// conversao que nao aconteceu le 85 C e fica fora da faixa.
+#define ACQ_TEMP_MIN -10.0f
+#define ACQ_TEMP_MAX 80.0f
+
+static volatile bool rescanRequested;
+static volatile float maxRangeCm[ACQ_CHANNELS];
+static volatile bool fineWanted[ACQ_CHANNELS];
+// Resolucao programada nos sensores; eles ligam com 12 bits da EEPROM
+static uint8_t busResolution = 12;
+static bool resolutionDirty = true;
+// ROM usada por canal, resolvida na busca
+static DeviceAddress sensors[ACQ_CHANNELS];
+static bool hasSensor[ACQ_CHANNELS];
+
+#if CONFIG_APP_ACQ_ALARM_SEARCH
+// Modo alarme: cada sensor recebe uma janela TH/TL em torno da ultima
+// leitura e so os que sairam dela aparecem na busca condicional. Os demais
+// mantem a leitura anterior, que difere da atual menos que a janela.
+static bool armed[ACQ_CHANNELS];
+static float lastTemperature[ACQ_CHANNELS];
+static int64_t lastFullRead;
+#endif
+
+static bool rom_is_zero(const uint8_t *rom)
+{
+    for (int i = 0; i < 8; i++)
+    {
+        if (rom[i] != 0)
+            return false;
+    }
+    return true;
+}
+
+static bool rom_configured(const acq_config_t *config, const uint8_t *rom)
+{
+    for (int i = 0; i < ACQ_CHANNELS; i++)
+    {
+        if (memcmp(config->channels[i].sensor, rom, 8) == 0)
+            return true;
+    }
+    return false;
+}
+
+void acq_set_range(int channel, float maxCm)
+{
+    if (channel >= 0 && channel < ACQ_CHANNELS)
+        maxRangeCm[channel] = maxCm;
+}
+
+void acq_set_precision(int channel, bool fine)
+{
+    if (channel >= 0 && channel < ACQ_CHANNELS)
+        fineWanted[channel] = fine;
+}
+
+void acq_request_rescan(void)
+{
+    rescanRequested = true;
+}
+
+// Canais com ROM configurada usam sempre o mesmo sensor; os demais
+// recebem, em ordem, os sensores achados que nao pertencem a outro canal.
+// Roda na tarefa de aquisicao, entre ciclos, para nao disputar o barramento.
+static void rescan_bus(const acq_config_t *config)
+{
+    rescanRequested = false;
+#if CONFIG_APP_ACQ_ALARM_SEARCH
+    // Um canal pode ter trocado de sensor: todos voltam a ser lidos
+    memset(armed, 0, sizeof(armed));
+#endif
+    uint8_t addr[8];
+    int found = 0;
+    int next = 0;
+
+    for (int i = 0; i < ACQ_CHANNELS; i++)
+    {
+        hasSensor[i] = !rom_is_zero(config->channels[i].sensor);
+        if (hasSensor[i])
+            memcpy(sensors[i], config->channels[i].sensor, 8);
+    }
+
+    power_busy_begin();
+    reset_search();
+    while (search(addr, true))
+    {
+        ESP_LOGI(ACQ_TAG, "DS18B20 %02x%02x%02x%02x%02x%02x%02x%02x",
+                 addr[0], addr[1], addr[2], addr[3], addr[4], addr[5], addr[6], addr[7]);
+        found++;
+        if (rom_configured(config, addr))
+            continue;
+        while (next < ACQ_CHANNELS && hasSensor[next])
+            next++;
+        if (next < ACQ_CHANNELS)
+        {
+            memcpy(sensors[next], addr, 8);
+            hasSensor[next] = true;
+        }
+    }
+    // Um sensor novo pode ter mudado o modo de alimentacao do barramento
+    ds18b20_detect_power();
+    power_busy_end();
+    resolutionDirty = true;
+    ESP_LOGI(ACQ_TAG, "%d sensor(es) no barramento%s", found,
+             ds18b20_is_parasite() ? ", alimentacao parasita" : "");
+    for (int i = 0; i < ACQ_CHANNELS; i++)
+    {
+        if (!hasSensor[i])
+            ESP_LOGW(ACQ_TAG, "Canal %d sem sensor de temperatura", i);
+    }
+}
+
+// Conversao de 9 bits leva 94 ms e a de 12 bits 750 ms: a resolucao maxima
+// so vale quando algum canal esta perto do limite. Reprogramada tambem apos
+// uma falha de leitura, porque um sensor reiniciado volta aos 12 bits.
+static void update_resolution(void)
+{
+    uint8_t wanted = CONFIG_APP_ACQ_COARSE_BITS;
+    DeviceAddress addresses[ACQ_CHANNELS];
+    int count = 0;
+    for (int ch = 0; ch < ACQ_CHANNELS; ch++)
+    {
+        if (!hasSensor[ch])
+            continue;
+        memcpy(addresses[count++], sensors[ch], 8);
+        if (fineWanted[ch])
+            wanted = 12;
+    }
+    if (count == 0 || (wanted == busResolution && !resolutionDirty))
+        return;
+
+    power_busy_begin();
+    bool ok = ds18b20_setResolution(addresses, count, wanted);
+    power_busy_end();
+    if (wanted != busResolution)
+        ESP_LOGI(ACQ_TAG, "Resolucao do DS18B20: %d bits", wanted);
+    busResolution = wanted;
+    resolutionDirty = !ok;
+}
+
+void acq_setup(void *arg)
+{
+    const acq_config_t *config = arg;
+    ranging_setup(config->channels);
+    ds18b20_init(config->ds18b20);
+    rescan_bus(config);
+}
+
+#if CONFIG_APP_ACQ_ALARM_SEARCH
+// Marca em read os canais a ler neste ciclo: os que alarmaram, os que ainda
+// nao tem janela, os que pediram resolucao maxima (perto do limite a janela
+// de graus inteiros esconderia a variacao que os 12 bits medem) e,
+// periodicamente, todos, porque um sensor desligado ou reiniciado (TH/TL
+// voltam da EEPROM) pode nunca entrar em alarme
+static void select_reads(bool *read, int64_t now)
+{
+    bool full = now - lastFullRead >= (int64_t)CONFIG_APP_ACQ_ALARM_REFRESH_MS * 1000;
+    for (int ch = 0; ch < ACQ_CHANNELS; ch++)
+        read[ch] = full || !armed[ch] || fineWanted[ch];
+    if (full)
+    {
+        lastFullRead = now;
+        return;
+    }
+
+    uint8_t addr[8];
+    power_busy_begin();
+    reset_search();
+    while (search(addr, false))
+    {
+        if (ds18b20_crc8(addr, 7) != addr[7]) // ultimo byte da ROM e o CRC
+        {
+            // ROM corrompida: nao da para saber quem alarmou
+            for (int ch = 0; ch < ACQ_CHANNELS; ch++)
+                read[ch] = true;
+            break;
+        }
+        for (int ch = 0; ch < ACQ_CHANNELS; ch++)
+        {
+            if (hasSensor[ch] && memcmp(sensors[ch], addr, 8) == 0)
+                read[ch] = true;
+        }
+    }
+    power_busy_end();
+}
+
+// O sensor compara so os graus inteiros da leitura com TH e TL
+static void arm_window(int ch, float temperature)
+{
+    int whole = (int)floorf(temperature);
+    armed[ch] = ds18b20_set_alarm_window(&sensors[ch], whole - CONFIG_APP_ACQ_ALARM_BAND,
+                                         whole + CONFIG_APP_ACQ_ALARM_BAND);
+    lastTemperature[ch] = temperature;
+}
+#endif
+
+// Um ciclo: dispara a conversao de todos os DS18B20 de uma vez, faz as
+// medidas ultrassonicas de todos os canais enquanto ela acontece e so entao
+// le as temperaturas, uma por ROM (no modo alarme, so as que sairam da
+// janela). O ciclo dura o tempo da conversao, e nao a soma das esperas;
+// com alimentacao propria, so o tempo que os sensores de fato levaram.
+void acq_task(void *arg)
+{
+    const acq_config_t *config = arg;
+    if (rescanRequested)
+        rescan_bus(config);
+
+    acq_sample_t sample = {0};
+    sample.timestamp = esp_timer_get_time();
+
+    update_resolution();
+    TRACE_BEGIN(TRACE_DS18B20_READ, 0);
+    power_busy_begin();
+    bool converting = ds18b20_start_conversion();
+    power_busy_end();
+
+    float ranges[ACQ_CHANNELS];
+    for (int ch = 0; ch < ACQ_CHANNELS; ch++)
+        ranges[ch] = maxRangeCm[ch];
+    power_busy_begin();
+    ranging_run(CONFIG_APP_ACQ_PINGS, ranges, sample.readings);
+    power_busy_end();
+
+    for (int ch = 0; ch < ACQ_CHANNELS; ch++)
+        sample.readings[ch].temperatureFault = ACQ_TIMEOUT;
+    // Sensores com alimentacao propria avisam o fim da conversao; fora das
+    // consultas de um slot a CPU pode dormir. Se algum ainda converte no
+    // fim da janela o barramento nao diz qual: nenhum scratchpad e lido e
+    // todos os canais ficam com ACQ_TIMEOUT. Um sensor reiniciado volta aos
+    // 12 bits e estoura a janela curta, entao a resolucao e reescrita.
+    if (converting && !ds18b20_wait_conversion())
+    {
+        resolutionDirty = true;
+        converting = false;
+    }
+    if (converting)
+    {
+#if CONFIG_APP_ACQ_ALARM_SEARCH
+        bool read[ACQ_CHANNELS];
+        select_reads(read, sample.timestamp);
+#endif
+        for (int ch = 0; ch < ACQ_CHANNELS; ch++)
+        {
+            if (!hasSensor[ch])
+                continue;
+            acq_reading_t *reading = &sample.readings[ch];
+#if CONFIG_APP_ACQ_ALARM_SEARCH
+            if (!read[ch])
+            {
+                reading->temperatureFault = ACQ_OK;
+                reading->temperatureValid = true;
+                reading->temperature = lastTemperature[ch];
+                continue;
+            }
+            armed[ch] = false;
+#endif
+            float temperature;
+            power_busy_begin();
+            ds18b20_status_t status = ds18b20_read_temp_rom(&sensors[ch], &temperature);
+            power_busy_end();
+            if (status != DS18B20_OK)
+                resolutionDirty = true;
+            if (status == DS18B20_NO_DEVICE)
+                continue;
+            if (status == DS18B20_CRC_ERROR)
+                reading->temperatureFault = ACQ_CRC;
+            else if (temperature < ACQ_TEMP_MIN || temperature > ACQ_TEMP_MAX)
+            {
+                reading->temperatureFault = ACQ_IMPLAUSIBLE;
+                resolutionDirty = true;
+            }
+            else
+            {
+                reading->temperatureFault = ACQ_OK;
+                reading->temperatureValid = true;
+                reading->temperature = temperature;
+#if CONFIG_APP_ACQ_ALARM_SEARCH
+                power_busy_begin();
+                arm_window(ch, temperature);
+                power_busy_end();
+#endif
+            }
+        }
+    }
+    TRACE_END(TRACE_DS18B20_READ, (int32_t)(sample.readings[0].temperature * 100));
+
+    if (config->onSample != NULL)
+        config->onSample(&sample);
+}
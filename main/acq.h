@@ -0,0 +1,76 @@
+#ifndef MAIN_ACQ_H_
+#define MAIN_ACQ_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sdkconfig.h>
+#include <driver/gpio.h>
+
+// Um canal por reservatorio: ate ACQ_RANGERS sensores ultrassonicos
+// proprios e um DS18B20 no barramento 1-Wire compartilhado
+#define ACQ_CHANNELS CONFIG_APP_TANK_COUNT
+#define ACQ_RANGERS CONFIG_APP_ACQ_RANGERS
+
+typedef struct
+{
+    gpio_num_t trigger;
+    gpio_num_t echo;
+} acq_ranger_t;
+
+typedef struct
+{
+    acq_ranger_t rangers[ACQ_RANGERS]; // redundantes: a mediana junta os ecos
+    int rangerCount;
+    uint8_t sensor[8]; // ROM do DS18B20; zeros: o proximo achado na busca
+} acq_channel_t;
+
+// Motivo de uma leitura invalida, para a supervisao dos sensores
+typedef enum
+{
+    ACQ_OK,
+    ACQ_TIMEOUT,     // o sensor nao respondeu ou nao foi achado
+    ACQ_CRC,         // leitura corrompida no barramento
+    ACQ_IMPLAUSIBLE, // resposta fora da faixa fisica
+} acq_fault_t;
+
+typedef struct
+{
+    float distanceCm;
+    float temperature;
+    bool distanceValid;
+    bool temperatureValid;
+    uint8_t distanceFault; // acq_fault_t
+    uint8_t temperatureFault;
+} acq_reading_t;
+
+// Conjunto de medidas de um mesmo ciclo de aquisicao
+typedef struct
+{
+    int64_t timestamp; // inicio do ciclo, esp_timer_get_time()
+    acq_reading_t readings[ACQ_CHANNELS];
+} acq_sample_t;
+
+typedef void (*acq_callback_t)(const acq_sample_t *sample);
+
+typedef struct
+{
+    acq_channel_t channels[ACQ_CHANNELS];
+    gpio_num_t ds18b20;
+    acq_callback_t onSample; // chamado na tarefa de aquisicao a cada ciclo
+} acq_config_t;
+
+// Setup e job para sched_task_t, com arg apontando para um acq_config_t
+void acq_setup(void *arg);
+void acq_task(void *arg);
+
+// Distancia maxima do sensor ao fundo, que limita a janela de eco do canal
+void acq_set_range(int channel, float maxCm);
+
+// Pede a resolucao maxima do DS18B20 do canal; sem ela o canal aceita
+// CONFIG_APP_ACQ_COARSE_BITS. O barramento converte na maior pedida.
+void acq_set_precision(int channel, bool fine);
+
+// Pede uma nova busca no barramento 1-Wire no inicio do proximo ciclo
+void acq_request_rescan(void);
+
+#endif /* MAIN_ACQ_H_ */
@@ -0,0 +1,89 @@
+#include <math.h>
+#include <string.h>
+#include <esp_log.h>
+#include "anomaly.h"
+
+#define ANOMALY_TAG "ANOMALY"
+#define ANOMALY_ALPHA 0.05f  // peso de cada amostra na media
+#define ANOMALY_SIGMAS 4.0f  // largura da faixa normal
+#define ANOMALY_MIN_STD 0.2f // %/min, evita faixa nula com nivel parado
+#define ANOMALY_LEARN 20     // amostras antes de sinalizar
+#define ANOMALY_SETTLE 5     // amostras ignoradas apos trocar a bomba
+#define ANOMALY_CONFIRM 3    // amostras anomalas seguidas para alarmar
+#define ANOMALY_MIN_FILL 0.1f // %/min, bomba ligada precisa no minimo disso
+
+void anomaly_init(anomaly_det_t *det)
+{
+    memset(det, 0, sizeof(anomaly_det_t));
+}
+
+static void stats_add(anomaly_stats_t *stats, float rate)
+{
+    if (stats->count++ == 0)
+    {
+        stats->mean = rate;
+        stats->var = 0;
+        return;
+    }
+    float diff = rate - stats->mean;
+    stats->mean += ANOMALY_ALPHA * diff;
+    stats->var = (1 - ANOMALY_ALPHA) * (stats->var + ANOMALY_ALPHA * diff * diff);
+}
+
+// Limite inferior da faixa normal, ou -INFINITY enquanto aprende
+static float stats_low(const anomaly_stats_t *stats)
+{
+    if (stats->count < ANOMALY_LEARN)
+        return -INFINITY;
+    float std = sqrtf(stats->var);
+    return stats->mean - ANOMALY_SIGMAS * (std > ANOMALY_MIN_STD ? std : ANOMALY_MIN_STD);
+}
+
+uint8_t anomaly_update(anomaly_det_t *det, bool pumpOn, float rate)
+{
+    if (pumpOn != det->pumpOn)
+    {
+        det->pumpOn = pumpOn;
+        det->settle = 0;
+        det->strikes = 0;
+    }
+    // A vazao estimada demora algumas amostras para refletir a troca
+    if (det->settle < ANOMALY_SETTLE)
+    {
+        det->settle++;
+        return det->alarms;
+    }
+
+    anomaly_stats_t *stats = pumpOn ? &det->pumping : &det->idle;
+    uint8_t flag = pumpOn ? ANOMALY_DRY_RUN : ANOMALY_LEAK;
+    bool abnormal = rate < stats_low(stats);
+    if (pumpOn && rate < ANOMALY_MIN_FILL)
+        abnormal = true;
+
+    uint8_t alarms = det->alarms;
+    if (abnormal)
+    {
+        if (++det->strikes >= ANOMALY_CONFIRM)
+            alarms |= flag;
+    }
+    else
+    {
+        // So amostras normais alimentam a faixa, para um defeito
+        // persistente nao virar o novo normal
+        det->strikes = 0;
+        alarms &= ~flag;
+        stats_add(stats, rate);
+    }
+
+    if (alarms != det->alarms)
+    {
+        if (alarms & ~det->alarms & ANOMALY_LEAK)
+            ESP_LOGE(ANOMALY_TAG, "Possivel vazamento: nivel caindo com a bomba desligada");
+        if (alarms & ~det->alarms & ANOMALY_DRY_RUN)
+            ESP_LOGE(ANOMALY_TAG, "Bomba ligada sem o nivel subir");
+        if (det->alarms & ~alarms)
+            ESP_LOGI(ANOMALY_TAG, "Alarme normalizado");
+    }
+    det->alarms = alarms;
+    return alarms;
+}
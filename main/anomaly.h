@@ -0,0 +1,36 @@
+#ifndef MAIN_ANOMALY_H_
+#define MAIN_ANOMALY_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define ANOMALY_LEAK 0x01     // nivel caindo mais rapido que o normal com a bomba desligada
+#define ANOMALY_DRY_RUN 0x02  // nivel sem subir como o esperado com a bomba ligada
+#define ANOMALY_LOW_LEVEL 0x04 // volume abaixo de lowLevelLitres, avaliado a cada amostra
+#define ANOMALY_SENSOR 0x08    // sensor em falha ou aquisicao parada, detalhes em health.h
+
+// Media e variancia exponenciais da vazao em um estado da bomba
+typedef struct
+{
+    float mean;
+    float var;
+    uint32_t count;
+} anomaly_stats_t;
+
+// Detector de memoria constante: aprende a faixa normal de vazao com a
+// bomba ligada e desligada e sinaliza amostras fora dela.
+typedef struct
+{
+    anomaly_stats_t idle;
+    anomaly_stats_t pumping;
+    bool pumpOn;
+    uint32_t settle;  // amostras desde a ultima troca da bomba
+    uint32_t strikes; // amostras anomalas seguidas
+    uint8_t alarms;
+} anomaly_det_t;
+
+void anomaly_init(anomaly_det_t *det);
+// rate em %/min; retorna os alarmes ativos (ANOMALY_*)
+uint8_t anomaly_update(anomaly_det_t *det, bool pumpOn, float rate);
+
+#endif /* MAIN_ANOMALY_H_ */
@@ -0,0 +1,227 @@
+#include <string.h>
+#include <sdkconfig.h>
+#include "binlog.h"
+#include "modbus.h"
+
+size_t binlog_encode(uint8_t type, const uint8_t *payload, size_t len, uint8_t *frame)
+{
+    uint8_t raw[1 + BINLOG_PAYLOAD_MAX + 2];
+    raw[0] = type;
+    memcpy(&raw[1], payload, len);
+    uint16_t crc = modbus_crc16(raw, len + 1);
+    raw[len + 1] = crc & 0xFF;
+    raw[len + 2] = crc >> 8;
+    size_t rawLen = len + 3;
+
+    // COBS: cada bloco comeca com a distancia ate o proximo zero, entao o
+    // unico 0x00 do quadro e o delimitador final
+    size_t out = 1;
+    size_t code = 0;
+    uint8_t run = 1;
+    for (size_t i = 0; i < rawLen; i++)
+    {
+        if (raw[i] == 0)
+        {
+            frame[code] = run;
+            code = out++;
+            run = 1;
+        }
+        else
+        {
+            frame[out++] = raw[i];
+            if (++run == 0xFF)
+            {
+                frame[code] = run;
+                code = out++;
+                run = 1;
+            }
+        }
+    }
+    frame[code] = run;
+    frame[out++] = 0;
+    return out;
+}
+
+#if CONFIG_APP_BINLOG
+#include <freertos/FreeRTOS.h>
+#include <driver/uart.h>
+#include <esp_log.h>
+#include <esp_pm.h>
+#include "history.h"
+#include "sched.h"
+#include "trace.h"
+
+#define BINLOG_TAG "BINLOG"
+#define BINLOG_UART CONFIG_APP_BINLOG_UART
+#define BINLOG_TX_BUFFER 2048
+#define BINLOG_TRACE_BATCH 32
+
+_Static_assert(BINLOG_FLAG_PUMP == HISTORY_PUMP && BINLOG_FLAG_HEATER == HISTORY_HEATER &&
+                   BINLOG_FLAG_TANK_SHIFT == HISTORY_TANK_SHIFT,
+               "flags do binlog diferentes do historico");
+
+static uint32_t historyCursor;
+// Ultima amostra de cada reservatorio, para detectar transicoes
+static history_sample_t lastSample[CONFIG_APP_TANK_COUNT];
+static bool haveLast[CONFIG_APP_TANK_COUNT];
+#if CONFIG_APP_BINLOG_TRACE
+static uint32_t traceCursor[portNUM_PROCESSORS];
+#endif
+#if CONFIG_APP_POWER_SAVE
+// A UART conta o baud pelo APB, que o DFS baixa para o XTAL: o clock fica
+// no maximo do primeiro quadro ate o ultimo bit sair do FIFO
+static esp_pm_lock_handle_t apbLock;
+#endif
+
+static size_t put_u16(uint8_t *data, uint16_t value)
+{
+    data[0] = value & 0xFF;
+    data[1] = value >> 8;
+    return 2;
+}
+
+static size_t put_u32(uint8_t *data, uint32_t value)
+{
+    put_u16(data, value & 0xFFFF);
+    put_u16(&data[2], value >> 16);
+    return 4;
+}
+
+// O driver copia o quadro para o buffer de TX e a ISR da UART o envia
+static void emit(uint8_t type, const uint8_t *payload, size_t len)
+{
+    uint8_t frame[BINLOG_FRAME_MAX];
+    size_t frameLen = binlog_encode(type, payload, len, frame);
+    uart_write_bytes(BINLOG_UART, frame, frameLen);
+}
+
+static void emit_lost(uint8_t source, uint32_t count)
+{
+    uint8_t payload[5];
+    payload[0] = source;
+    put_u32(&payload[1], count);
+    emit(BINLOG_LOST, payload, sizeof(payload));
+}
+
+static void emit_change(uint8_t type, uint32_t time, uint8_t tank, uint8_t a, uint8_t b)
+{
+    uint8_t payload[7];
+    put_u32(payload, time);
+    payload[4] = tank;
+    payload[5] = a;
+    payload[6] = b;
+    emit(type, payload, sizeof(payload));
+}
+
+static void emit_sample(uint32_t seq, const history_sample_t *s)
+{
+    uint8_t payload[16];
+    size_t len = put_u32(payload, seq);
+    len += put_u32(&payload[len], s->time);
+    len += put_u16(&payload[len], s->level);
+    len += put_u16(&payload[len], s->temperature);
+    len += put_u16(&payload[len], s->rate);
+    payload[len++] = s->flags;
+    payload[len++] = s->alarms;
+    emit(BINLOG_SAMPLE, payload, len);
+
+    // Transicoes de atuadores e alarmes saem das diferencas entre amostras
+    // do mesmo reservatorio
+    uint8_t tank = HISTORY_TANK(s->flags);
+    if (tank >= CONFIG_APP_TANK_COUNT)
+        return;
+    if (haveLast[tank])
+    {
+        const history_sample_t *last = &lastSample[tank];
+        uint8_t changed = s->flags ^ last->flags;
+        if (changed & HISTORY_PUMP)
+            emit_change(BINLOG_ACTUATOR, s->time, tank, BINLOG_ACTUATOR_PUMP, (s->flags & HISTORY_PUMP) != 0);
+        if (changed & HISTORY_HEATER)
+            emit_change(BINLOG_ACTUATOR, s->time, tank, BINLOG_ACTUATOR_HEATER, (s->flags & HISTORY_HEATER) != 0);
+        if (s->alarms != last->alarms)
+            emit_change(BINLOG_ALARM, s->time, tank, s->alarms, last->alarms);
+    }
+    lastSample[tank] = *s;
+    haveLast[tank] = true;
+}
+
+static void binlog_job(void *arg)
+{
+#if CONFIG_APP_POWER_SAVE
+    esp_pm_lock_acquire(apbLock);
+#endif
+    uint32_t head = history_head();
+    uint32_t tail = history_tail();
+    if (historyCursor < tail)
+    {
+        emit_lost(BINLOG_SOURCE_HISTORY, tail - historyCursor);
+        historyCursor = tail;
+    }
+    for (; historyCursor < head; historyCursor++)
+    {
+        history_sample_t s;
+        if (history_get(historyCursor, &s))
+            emit_sample(historyCursor, &s);
+    }
+
+#if CONFIG_APP_BINLOG_TRACE
+    uint32_t lost = 0;
+    for (int core = 0; core < portNUM_PROCESSORS; core++)
+    {
+        trace_event_t events[BINLOG_TRACE_BATCH];
+        uint32_t count;
+        while ((count = trace_read(core, &traceCursor[core], events, BINLOG_TRACE_BATCH, &lost)) > 0)
+        {
+            for (uint32_t i = 0; i < count; i++)
+            {
+                uint8_t payload[9];
+                payload[0] = core;
+                put_u32(&payload[1], events[i].ts);
+                put_u16(&payload[5], events[i].id);
+                put_u16(&payload[7], events[i].arg);
+                emit(BINLOG_TRACE, payload, sizeof(payload));
+            }
+        }
+    }
+    if (lost > 0)
+        emit_lost(BINLOG_SOURCE_TRACE, lost);
+#endif
+
+#if CONFIG_APP_POWER_SAVE
+    uart_wait_tx_done(BINLOG_UART, portMAX_DELAY);
+    esp_pm_lock_release(apbLock);
+#endif
+}
+
+static sched_task_t binlogTask = {
+    .name = "binlog_task",
+    .job = binlog_job,
+    .periodMs = CONFIG_APP_BINLOG_PERIOD_MS,
+    .stackSize = 2560,
+    .priority = 1,
+    .core = CONFIG_APP_UI_CORE,
+};
+
+void binlog_start(void)
+{
+    uart_config_t config = {
+        .baud_rate = CONFIG_APP_BINLOG_BAUD,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        .source_clk = UART_SCLK_APB,
+    };
+    // So transmite: o RX minimo exigido pelo driver nao e usado
+    ESP_ERROR_CHECK(uart_driver_install(BINLOG_UART, 256, BINLOG_TX_BUFFER, 0, NULL, 0));
+    ESP_ERROR_CHECK(uart_param_config(BINLOG_UART, &config));
+    ESP_ERROR_CHECK(uart_set_pin(BINLOG_UART, CONFIG_APP_BINLOG_TX_GPIO, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE));
+#if CONFIG_APP_POWER_SAVE
+    ESP_ERROR_CHECK(esp_pm_lock_create(ESP_PM_APB_FREQ_MAX, 0, "binlog", &apbLock));
+#endif
+
+    historyCursor = history_tail();
+    sched_start(&binlogTask);
+    ESP_LOGI(BINLOG_TAG, "UART%d a %d baud", BINLOG_UART, CONFIG_APP_BINLOG_BAUD);
+}
+#endif
@@ -0,0 +1,38 @@
+#ifndef MAIN_BINLOG_H_
+#define MAIN_BINLOG_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Telemetria binaria pela UART, decodificada no PC por
+// tools/telemetry_decoder. Cada quadro e
+//   COBS(tipo | payload | CRC-16/MODBUS do tipo e payload) 0x00
+// e os campos multibyte vao em little endian.
+
+#define BINLOG_SAMPLE 0x01   // u32 seq, u32 t (s), i16 nivel, i16 temperatura, i16 vazao (x100), u8 flags, u8 alarmes
+#define BINLOG_ACTUATOR 0x02 // u32 t (s), u8 reservatorio, u8 atuador, u8 ligado
+#define BINLOG_ALARM 0x03    // u32 t (s), u8 reservatorio, u8 alarmes, u8 alarmes anteriores
+#define BINLOG_TRACE 0x04    // u8 core, u32 ts (us), u16 id, u16 arg
+#define BINLOG_LOST 0x05     // u8 origem, u32 registros perdidos antes do envio
+
+// flags da amostra como em history.h: bit 0 bomba, bit 1 resistencia,
+// bits 4-7 reservatorio a partir de 0
+#define BINLOG_FLAG_PUMP 0x01
+#define BINLOG_FLAG_HEATER 0x02
+#define BINLOG_FLAG_TANK_SHIFT 4
+
+#define BINLOG_ACTUATOR_PUMP 0
+#define BINLOG_ACTUATOR_HEATER 1
+#define BINLOG_SOURCE_HISTORY 0
+#define BINLOG_SOURCE_TRACE 1
+
+#define BINLOG_PAYLOAD_MAX 32
+// Tipo e CRC, mais um byte de overhead do COBS e o delimitador
+#define BINLOG_FRAME_MAX (1 + BINLOG_PAYLOAD_MAX + 2 + 1 + 1)
+
+// Monta um quadro completo em frame (BINLOG_FRAME_MAX bytes) e retorna o tamanho
+size_t binlog_encode(uint8_t type, const uint8_t *payload, size_t len, uint8_t *frame);
+
+void binlog_start(void);
+
+#endif /* MAIN_BINLOG_H_ */
@@ -0,0 +1,217 @@
+#include <sdkconfig.h>
+#if CONFIG_APP_CONSOLE
+#include <stdio.h>
+#include <stdlib.h>
+#include <esp_log.h>
+#include <esp_console.h>
+#include "console.h"
+#include "state.h"
+#include "tank.h"
+#include "diag.h"
+#include "acq.h"
+#include "trace.h"
+
+#define CONSOLE_TAG "CONSOLE"
+#define CONSOLE_MAX_SET 8 // pares nome/valor por comando set
+
+static console_change_t changeCallback;
+
+static void print_param(const state_t *state, const state_param_t *param, int tank)
+{
+    char name[32];
+    if (param->perTank)
+        snprintf(name, sizeof(name), "%s[%d]", param->name, tank + 1);
+    else
+        snprintf(name, sizeof(name), "%s", param->name);
+    printf("%-24s %g  [%g, %g]\n", name, state_param_get(state, param, tank), param->min, param->max);
+}
+
+static int cmd_get(int argc, char **argv)
+{
+    state_t state;
+    state_get(&state);
+    if (argc > 1)
+    {
+        state_param_update_t update;
+        if (!state_param_parse(argv[1], &update))
+        {
+            printf("parametro desconhecido: %s\n", argv[1]);
+            return 1;
+        }
+        print_param(&state, update.param, update.tank);
+        return 0;
+    }
+
+    int count;
+    const state_param_t *params = state_params(&count);
+    for (int i = 0; i < count; i++)
+    {
+        for (int tank = 0; tank < (params[i].perTank ? CONFIG_APP_TANK_COUNT : 1); tank++)
+            print_param(&state, &params[i], tank);
+    }
+    return 0;
+}
+
+// Todos os pares sao validados antes e aplicados numa unica escrita do
+// estado, para a malha de controle nunca ver uma combinacao pela metade
+static int cmd_set(int argc, char **argv)
+{
+    if (argc < 3 || (argc - 1) % 2 != 0 || (argc - 1) / 2 > CONSOLE_MAX_SET)
+    {
+        printf("uso: set nome valor [nome valor ...]\n");
+        return 1;
+    }
+
+    state_param_update_t updates[CONSOLE_MAX_SET];
+    int count = (argc - 1) / 2;
+    for (int i = 0; i < count; i++)
+    {
+        const char *name = argv[1 + 2 * i];
+        const char *text = argv[2 + 2 * i];
+        char *end;
+        bool known = state_param_parse(name, &updates[i]);
+        updates[i].value = strtof(text, &end);
+        if (!known || end == text || *end != '\0')
+        {
+            printf("invalido: %s %s\n", name, text);
+            return 1;
+        }
+    }
+
+    int rejected = state_params_set(updates, count);
+    if (rejected >= 0)
+    {
+        const state_param_t *param = updates[rejected].param;
+        printf("fora da faixa: %s [%g, %g]\n", argv[1 + 2 * rejected], param->min, param->max);
+        return 1;
+    }
+    if (changeCallback != NULL)
+        changeCallback();
+    return 0;
+}
+
+static int cmd_status(int argc, char **argv)
+{
+    state_t state;
+    state_get(&state);
+    printf("tempo %lld s\n", (long long)(state.timestamp / 1000000));
+    for (int i = 0; i < CONFIG_APP_TANK_COUNT; i++)
+    {
+        const tank_state_t *tank = &state.tanks[i];
+        printf("[%d] %s\n", i + 1, tankConfigs[i].name);
+        printf("  nivel %.2f %% (%.2f cm), %.1f de %.1f L\n",
+               tank->waterPercent, tank->waterDistance, tank->waterLitres, tank->capacityLitres);
+        printf("  vazao %.2f %%/min, eta %d s\n", tank->levelRate, (int)tank->etaSeconds);
+        printf("  temperatura %.2f C\n", tank->waterTemperature);
+        printf("  bomba %s, resistencia %s, alarmes 0x%02x, falhas 0x%02x\n",
+               tank->pumpOn ? "ligada" : "desligada", tank->heaterOn ? "ligada" : "desligada", tank->alarms,
+               tank->faults);
+    }
+    return 0;
+}
+
+// Sem pares mostra a tabela atual; com pares a substitui inteira
+static int cmd_strap(int argc, char **argv)
+{
+    int tank = argc > 1 ? atoi(argv[1]) : 0;
+    if (tank < 1 || tank > CONFIG_APP_TANK_COUNT || argc % 2 != 0 || (argc - 2) / 2 > GEOMETRY_POINTS_MAX)
+    {
+        printf("uso: strap reservatorio [altura_cm litros ...]\n");
+        return 1;
+    }
+
+    geometry_point_t points[GEOMETRY_POINTS_MAX];
+    int count = (argc - 2) / 2;
+    if (count == 0)
+    {
+        count = tank_get_table(tank - 1, points);
+        for (int i = 0; i < count; i++)
+            printf("%8.2f cm %10.2f L\n", points[i].levelCm, points[i].litres);
+        return 0;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        char *levelEnd;
+        char *litresEnd;
+        points[i].levelCm = strtof(argv[2 + 2 * i], &levelEnd);
+        points[i].litres = strtof(argv[3 + 2 * i], &litresEnd);
+        if (levelEnd == argv[2 + 2 * i] || *levelEnd != '\0' ||
+            litresEnd == argv[3 + 2 * i] || *litresEnd != '\0')
+        {
+            printf("invalido: %s %s\n", argv[2 + 2 * i], argv[3 + 2 * i]);
+            return 1;
+        }
+    }
+    if (!tank_set_table(tank - 1, points, count))
+    {
+        printf("tabela recusada: alturas devem crescer e os volumes nao podem cair\n");
+        return 1;
+    }
+    printf("tabela com %d pontos; vale com shape[%d] = %d\n", count, tank, GEOMETRY_TABLE);
+    return 0;
+}
+
+static int cmd_stats(int argc, char **argv)
+{
+    diag_info_t info;
+    diag_get(&info);
+    printf("heap %u livre, %u minimo\n", (unsigned)info.heapFree, (unsigned)info.heapMinFree);
+    printf("display %u transacoes, %u bytes\n", (unsigned)info.displayTransactions, (unsigned)info.displayBytes);
+    printf("1-wire %u resets, %u slots\n", (unsigned)info.oneWireResets, (unsigned)info.oneWireSlots);
+    for (int i = 0; i < info.taskCount; i++)
+    {
+        const diag_task_t *task = &info.tasks[i];
+        printf("%-12s core %d cpu %3u%% pilha %u/%u%s\n", task->name, task->core, task->cpuPercent,
+               (unsigned)(task->stackSize - task->stackFreeMin), (unsigned)task->stackSize,
+               task->lowStack ? " BAIXA" : "");
+    }
+    return 0;
+}
+
+static int cmd_trace(int argc, char **argv)
+{
+    trace_dump();
+    return 0;
+}
+
+static int cmd_rescan(int argc, char **argv)
+{
+    // A busca roda na tarefa de aquisicao; o resultado sai no log
+    acq_request_rescan();
+    printf("busca agendada para o proximo ciclo\n");
+    return 0;
+}
+
+static const esp_console_cmd_t commands[] = {
+    {.command = "get", .help = "Mostra os parametros ajustaveis", .hint = "[nome]", .func = cmd_get},
+    {.command = "set", .help = "Altera parametros de forma atomica", .hint = "nome valor [nome valor ...]", .func = cmd_set},
+    {.command = "status", .help = "Medidas e atuadores", .func = cmd_status},
+    {.command = "strap", .help = "Mostra ou troca a tabela de arqueacao", .hint = "reservatorio [altura_cm litros ...]", .func = cmd_strap},
+    {.command = "stats", .help = "Tarefas, heap e barramentos", .func = cmd_stats},
+    {.command = "trace", .help = "Descarrega o rastreamento", .func = cmd_trace},
+    {.command = "rescan", .help = "Busca os DS18B20 no barramento", .func = cmd_rescan},
+};
+
+void console_start(console_change_t onChange)
+{
+    changeCallback = onChange;
+
+    esp_console_repl_t *repl = NULL;
+    esp_console_repl_config_t replConfig = ESP_CONSOLE_REPL_CONFIG_DEFAULT();
+    replConfig.prompt = "caixa>";
+    replConfig.task_stack_size = CONFIG_APP_CONSOLE_STACK;
+    esp_console_dev_uart_config_t uartConfig = ESP_CONSOLE_DEV_UART_CONFIG_DEFAULT();
+    if (esp_console_new_repl_uart(&uartConfig, &replConfig, &repl) != ESP_OK)
+    {
+        ESP_LOGE(CONSOLE_TAG, "Falha ao iniciar o console");
+        return;
+    }
+
+    esp_console_register_help_command();
+    for (size_t i = 0; i < sizeof(commands) / sizeof(commands[0]); i++)
+        esp_console_cmd_register(&commands[i]);
+    esp_console_start_repl(repl);
+}
+
+#endif
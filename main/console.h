@@ -0,0 +1,19 @@
+#ifndef MAIN_CONSOLE_H_
+#define MAIN_CONSOLE_H_
+
+typedef void (*console_change_t)(void);
+
+// REPL na UART do console (a mesma dos logs), com os comandos:
+//   get [nome]             parametros ajustaveis, todos ou um
+//   set nome valor ...     altera um ou mais parametros de uma vez
+//   status                 medidas e atuadores de cada reservatorio
+//   strap N [cm litros ...] tabela de arqueacao do reservatorio N
+//   stats                  tarefas, heap e trafego nos barramentos
+//   trace                  descarrega o buffer de rastreamento no log
+//   rescan                 busca os DS18B20 no barramento 1-Wire
+// Parametros por reservatorio levam o numero dele, como em
+// "set storageCapacityLimit[2] 80"; sem o numero vale o primeiro.
+// onChange e chamado apos um set aceito.
+void console_start(console_change_t onChange);
+
+#endif /* MAIN_CONSOLE_H_ */
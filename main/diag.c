@@ -0,0 +1,191 @@
+#include <string.h>
+#include <esp_log.h>
+#include <esp_system.h>
+#include "diag.h"
+#include "fixfmt.h"
+#include "ssd1306.h"
+#include "ds18b20.h"
+
+#define DIAG_TAG "DIAG"
+
+static diag_info_t diagInfo;
+static portMUX_TYPE diagMux = portMUX_INITIALIZER_UNLOCKED;
+
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+static uint32_t lastRunTime[DIAG_MAX_TASKS];
+static uint32_t lastTotalRunTime;
+#endif
+
+void diag_register_task(TaskHandle_t handle, const char *name, uint32_t stackSize, BaseType_t core)
+{
+    portENTER_CRITICAL(&diagMux);
+    if (diagInfo.taskCount < DIAG_MAX_TASKS)
+    {
+        diag_task_t *task = &diagInfo.tasks[diagInfo.taskCount++];
+        task->name = name;
+        task->handle = handle;
+        task->stackSize = stackSize;
+        task->stackFreeMin = stackSize;
+        task->core = core;
+    }
+    portEXIT_CRITICAL(&diagMux);
+}
+
+BaseType_t diag_task_create(TaskFunction_t task, const char *name, uint32_t stackSize, void *param, UBaseType_t priority, BaseType_t core)
+{
+    TaskHandle_t handle = NULL;
+    BaseType_t ret = xTaskCreatePinnedToCore(task, name, stackSize, param, priority, &handle, core);
+    if (ret == pdPASS)
+        diag_register_task(handle, name, stackSize, core);
+    else
+        ESP_LOGE(DIAG_TAG, "Falha ao criar %s", name);
+    return ret;
+}
+
+void diag_get(diag_info_t *info)
+{
+    portENTER_CRITICAL(&diagMux);
+    *info = diagInfo;
+    portEXIT_CRITICAL(&diagMux);
+}
+
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+// Fatia de CPU de cada tarefa registrada desde a amostra anterior
+static void diag_sample_cpu(uint8_t *cpuPercent)
+{
+    static TaskStatus_t status[DIAG_MAX_TASKS + 8];
+    uint32_t totalRunTime = 0;
+    UBaseType_t count = uxTaskGetSystemState(status, DIAG_MAX_TASKS + 8, &totalRunTime);
+    // O total e o tempo de um core, as duas CPUs somam 2x
+    uint32_t elapsed = (totalRunTime - lastTotalRunTime) * portNUM_PROCESSORS;
+    lastTotalRunTime = totalRunTime;
+
+    for (int i = 0; i < diagInfo.taskCount; i++)
+    {
+        for (UBaseType_t j = 0; j < count; j++)
+        {
+            if (status[j].xHandle != diagInfo.tasks[i].handle)
+                continue;
+            uint32_t delta = status[j].ulRunTimeCounter - lastRunTime[i];
+            lastRunTime[i] = status[j].ulRunTimeCounter;
+            cpuPercent[i] = elapsed ? (uint64_t)delta * 100 / elapsed : 0;
+            break;
+        }
+    }
+}
+#endif
+
+static void diag_task(void *pvParams)
+{
+    ssd1306_stats_t lastDisplay = {0};
+    ds18b20_stats_t lastOneWire = {0};
+    for (;;)
+    {
+        ssd1306_stats_t display;
+        ds18b20_stats_t oneWire;
+        ssd1306_get_stats(&display);
+        ds18b20_get_stats(&oneWire);
+
+        uint8_t cpuPercent[DIAG_MAX_TASKS] = {0};
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+        diag_sample_cpu(cpuPercent);
+#endif
+        // Em ESP-IDF a marca d'agua ja vem em bytes
+        uint32_t stackFree[DIAG_MAX_TASKS];
+        int count = diagInfo.taskCount;
+        for (int i = 0; i < count; i++)
+            stackFree[i] = uxTaskGetStackHighWaterMark(diagInfo.tasks[i].handle);
+
+        portENTER_CRITICAL(&diagMux);
+        diagInfo.heapFree = esp_get_free_heap_size();
+        diagInfo.heapMinFree = esp_get_minimum_free_heap_size();
+        diagInfo.displayTransactions = display.transactions - lastDisplay.transactions;
+        diagInfo.displayBytes = display.bytes - lastDisplay.bytes;
+        diagInfo.oneWireResets = oneWire.resets - lastOneWire.resets;
+        diagInfo.oneWireSlots = oneWire.slots - lastOneWire.slots;
+        for (int i = 0; i < count; i++)
+        {
+            diag_task_t *task = &diagInfo.tasks[i];
+            if (stackFree[i] < task->stackFreeMin)
+                task->stackFreeMin = stackFree[i];
+            task->cpuPercent = cpuPercent[i];
+            task->lowStack = task->stackFreeMin < CONFIG_APP_DIAG_STACK_WARN;
+        }
+        portEXIT_CRITICAL(&diagMux);
+
+        for (int i = 0; i < count; i++)
+        {
+            diag_task_t *task = &diagInfo.tasks[i];
+            if (task->lowStack)
+                ESP_LOGW(DIAG_TAG, "%s: pilha livre %u de %u bytes", task->name, (unsigned)task->stackFreeMin, (unsigned)task->stackSize);
+            ESP_LOGD(DIAG_TAG, "%s: core %d, cpu %u%%, pilha livre %u", task->name, task->core, task->cpuPercent, (unsigned)task->stackFreeMin);
+        }
+        ESP_LOGD(DIAG_TAG, "heap livre %u, minimo %u", (unsigned)diagInfo.heapFree, (unsigned)diagInfo.heapMinFree);
+        // Linha chave=valor para acompanhar regressoes de trafego entre versoes
+        ESP_LOGI(DIAG_TAG, "bus period_ms=%d oled_tx=%u oled_bytes=%u ow_resets=%u ow_slots=%u", CONFIG_APP_DIAG_PERIOD_MS,
+                 (unsigned)diagInfo.displayTransactions, (unsigned)diagInfo.displayBytes,
+                 (unsigned)diagInfo.oneWireResets, (unsigned)diagInfo.oneWireSlots);
+        lastDisplay = display;
+        lastOneWire = oneWire;
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_APP_DIAG_PERIOD_MS));
+    }
+}
+
+void diag_start(void)
+{
+    diag_task_create(&diag_task, "diag_task", 2048, NULL, 1, 0);
+}
+
+#if CONFIG_APP_DIAG_SCREEN
+// Copia formatada pelos widgets: diagInfo e reescrito pela tarefa de
+// diagnostico no outro core e so pode ser lido com diagMux
+static diag_info_t diagView;
+
+void diag_refresh(void)
+{
+    diag_get(&diagView);
+}
+
+static int format_heap(char *buf, size_t size, const volatile void *value)
+{
+    return fmt_fixed(buf, size, diagView.heapMinFree, 0, " B", 0);
+}
+
+// Linha por tarefa: nome abreviado, folga de pilha e uso de CPU
+static int format_task(char *buf, size_t size, const volatile void *value)
+{
+    int index = *(const int *)value;
+    if (index >= diagView.taskCount || size == 0)
+    {
+        buf[0] = '\0';
+        return 0;
+    }
+    const diag_task_t *task = &diagView.tasks[index];
+    size_t len = 0;
+    for (const char *c = task->name; *c != '\0' && *c != '_' && len < 6 && len < size - 1; c++)
+        buf[len++] = *c;
+    if (len < size - 1)
+        buf[len++] = task->lowStack ? '!' : ' ';
+    len += fmt_fixed(&buf[len], size - len, task->stackFreeMin, 0, NULL, 4);
+    len += fmt_fixed(&buf[len], size - len, task->cpuPercent, 0, "%", 4);
+    return len;
+}
+
+static const int taskIndex[] = {0, 1, 2, 3, 4, 5};
+
+static widget_t diagWidgets[] = {
+    WIDGET_FIELD(0, "Heap ", format_heap, NULL),
+    WIDGET_FIELD(2, NULL, format_task, &taskIndex[0]),
+    WIDGET_FIELD(3, NULL, format_task, &taskIndex[1]),
+    WIDGET_FIELD(4, NULL, format_task, &taskIndex[2]),
+    WIDGET_FIELD(5, NULL, format_task, &taskIndex[3]),
+    WIDGET_FIELD(6, NULL, format_task, &taskIndex[4]),
+    WIDGET_FIELD(7, NULL, format_task, &taskIndex[5]),
+};
+
+widget_t *diag_widgets(int *count)
+{
+    *count = sizeof(diagWidgets) / sizeof(diagWidgets[0]);
+    return diagWidgets;
+}
+#endif
@@ -0,0 +1,48 @@
+#ifndef MAIN_DIAG_H_
+#define MAIN_DIAG_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "widgets.h"
+
+#define DIAG_MAX_TASKS 8
+
+typedef struct
+{
+    const char *name;
+    TaskHandle_t handle;
+    uint32_t stackSize;     // bytes
+    uint32_t stackFreeMin;  // menor folga de pilha ja vista, em bytes
+    uint8_t cpuPercent;     // uso de CPU no ultimo periodo (0 sem run-time stats)
+    int8_t core;
+    bool lowStack;
+} diag_task_t;
+
+typedef struct
+{
+    uint32_t heapFree;
+    uint32_t heapMinFree;
+    // Trafego nos barramentos durante o ultimo periodo
+    uint32_t displayTransactions;
+    uint32_t displayBytes;
+    uint32_t oneWireResets;
+    uint32_t oneWireSlots;
+    int taskCount;
+    diag_task_t tasks[DIAG_MAX_TASKS];
+} diag_info_t;
+
+// Cria a tarefa fixada no core e a registra para monitoramento
+BaseType_t diag_task_create(TaskFunction_t task, const char *name, uint32_t stackSize, void *param, UBaseType_t priority, BaseType_t core);
+void diag_register_task(TaskHandle_t handle, const char *name, uint32_t stackSize, BaseType_t core);
+void diag_start(void);
+void diag_get(diag_info_t *info);
+
+#if CONFIG_APP_DIAG_SCREEN
+widget_t *diag_widgets(int *count);
+// Copia o estado para os widgets; chamado com o lock da tela
+void diag_refresh(void);
+#endif
+
+#endif /* MAIN_DIAG_H_ */
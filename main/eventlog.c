@@ -0,0 +1,78 @@
+#include <stdio.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include "eventlog.h"
+#include "widgets.h"
+#include "health.h"
+#include "anomaly.h"
+
+typedef struct
+{
+    uint8_t mask;
+    const char *label;
+} eventlog_bit_t;
+
+static const eventlog_bit_t faultBits[] = {
+    {HEALTH_STALLED, "parada"},
+    {HEALTH_LEVEL_FAILED, "falha nivel"},
+    {HEALTH_TEMP_FAILED, "falha temp"},
+};
+
+static const eventlog_bit_t alarmBits[] = {
+    {ANOMALY_LEAK, "vazamento"},
+    {ANOMALY_DRY_RUN, "bomba seca"},
+    {ANOMALY_LOW_LEVEL, "nivel baixo"},
+};
+
+// Gravado pela aquisicao e pelo vigia, lido pela interface no outro core
+static portMUX_TYPE logMux = portMUX_INITIALIZER_UNLOCKED;
+static char lines[EVENTLOG_LINES][WIDGET_TEXT_MAX + 1];
+static uint32_t head;
+
+// "C1 +vazamento" ao entrar, "C1 -vazamento" ao sair
+static void eventlog_add(int tank, bool set, const char *label)
+{
+    char text[WIDGET_TEXT_MAX + 1];
+    snprintf(text, sizeof(text), "C%d %c%s", tank + 1, set ? '+' : '-', label);
+    portENTER_CRITICAL(&logMux);
+    memcpy(lines[head % EVENTLOG_LINES], text, sizeof(text));
+    head++;
+    portEXIT_CRITICAL(&logMux);
+}
+
+static void compare_bits(int tank, const eventlog_bit_t *bits, int count, uint8_t before, uint8_t after)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if ((before ^ after) & bits[i].mask)
+            eventlog_add(tank, (after & bits[i].mask) != 0, bits[i].label);
+    }
+}
+
+void eventlog_compare(int tank, const tank_state_t *before, const tank_state_t *after)
+{
+    compare_bits(tank, faultBits, sizeof(faultBits) / sizeof(faultBits[0]), before->faults, after->faults);
+    compare_bits(tank, alarmBits, sizeof(alarmBits) / sizeof(alarmBits[0]), before->alarms, after->alarms);
+    if (before->pumpOn != after->pumpOn)
+        eventlog_add(tank, after->pumpOn, "bomba");
+    if (before->heaterOn != after->heaterOn)
+        eventlog_add(tank, after->heaterOn, "resist.");
+}
+
+int eventlog_next(uint32_t *cursor, char *buf, size_t size)
+{
+    int len = -1;
+    portENTER_CRITICAL(&logMux);
+    if (head - *cursor > EVENTLOG_LINES)
+        *cursor = head - EVENTLOG_LINES;
+    if (*cursor != head)
+    {
+        const char *line = lines[*cursor % EVENTLOG_LINES];
+        len = strnlen(line, size - 1);
+        memcpy(buf, line, len);
+        buf[len] = '\0';
+        (*cursor)++;
+    }
+    portEXIT_CRITICAL(&logMux);
+    return len;
+}
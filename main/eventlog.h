@@ -0,0 +1,20 @@
+#ifndef MAIN_EVENTLOG_H_
+#define MAIN_EVENTLOG_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "state.h"
+
+// Registro das ultimas mudancas de atuadores, alarmes e falhas, uma linha
+// do display por evento. A tela de eventos rola pela linha inicial do
+// SSD1306 (ssd1306_ticker_*): cada evento novo custa uma pagina enviada.
+#define EVENTLOG_LINES 8 // paginas da GDDRAM: o que cabe no anel do ticker
+
+// Registra os eventos entre dois estados do mesmo reservatorio
+void eventlog_compare(int tank, const tank_state_t *before, const tank_state_t *after);
+
+// Copia em buf o evento seguinte a *cursor e o avanca; retorna o tamanho
+// do texto ou -1 sem eventos novos. Eventos ja descartados sao pulados.
+int eventlog_next(uint32_t *cursor, char *buf, size_t size);
+
+#endif /* MAIN_EVENTLOG_H_ */
@@ -0,0 +1,54 @@
+#include "fixfmt.h"
+
+static const int32_t pow10[] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+
+#define FIXFMT_MAX_DECIMALS 6
+
+int fmt_fixed(char *buf, size_t size, int32_t value, int decimals, const char *unit, int width)
+{
+    if (size == 0)
+        return 0;
+    if (decimals < 0)
+        decimals = 0;
+    if (decimals > FIXFMT_MAX_DECIMALS)
+        decimals = FIXFMT_MAX_DECIMALS;
+
+    // Digitos gerados do menos para o mais significativo
+    char digits[16];
+    int n = 0;
+    uint32_t magnitude = value < 0 ? 0u - (uint32_t)value : (uint32_t)value;
+    do
+    {
+        digits[n++] = '0' + magnitude % 10;
+        magnitude /= 10;
+        if (n == decimals)
+            digits[n++] = '.';
+    } while (magnitude != 0 || n <= decimals + (decimals > 0));
+    if (value < 0)
+        digits[n++] = '-';
+
+    int unitLen = 0;
+    if (unit != NULL)
+        while (unit[unitLen] != '\0')
+            unitLen++;
+
+    size_t len = 0;
+    for (int pad = width - n - unitLen; pad > 0 && len < size - 1; pad--)
+        buf[len++] = ' ';
+    while (n > 0 && len < size - 1)
+        buf[len++] = digits[--n];
+    for (int i = 0; i < unitLen && len < size - 1; i++)
+        buf[len++] = unit[i];
+    buf[len] = '\0';
+    return len;
+}
+
+int32_t fix_from_float(float value, int decimals)
+{
+    if (decimals < 0)
+        decimals = 0;
+    if (decimals > FIXFMT_MAX_DECIMALS)
+        decimals = FIXFMT_MAX_DECIMALS;
+    float scaled = value * pow10[decimals];
+    return (int32_t)(scaled < 0 ? scaled - 0.5f : scaled + 0.5f);
+}
@@ -0,0 +1,17 @@
+#ifndef MAIN_FIXFMT_H_
+#define MAIN_FIXFMT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Formatacao de numeros em ponto fixo sem printf de float e sem alocacao.
+// value e um inteiro escalado por 10^decimals: 2150 com 2 casas vira "21.50".
+// unit (pode ser NULL) e anexado ao final e width e a largura minima,
+// completada com espacos a esquerda. Retorna o tamanho escrito em buf,
+// truncando se nao couber (buf sempre termina em '\0').
+int fmt_fixed(char *buf, size_t size, int32_t value, int decimals, const char *unit, int width);
+
+// Converte para ponto fixo arredondando para o inteiro mais proximo
+int32_t fix_from_float(float value, int decimals);
+
+#endif /* MAIN_FIXFMT_H_ */
@@ -0,0 +1,140 @@
+#include <math.h>
+#include <stddef.h>
+#include "geometry.h"
+
+#define GEOMETRY_PI 3.14159265f
+
+// Volume em litros de cada perfil analitico para a altura h (cm)
+static float cylinder_litres(const geometry_profile_t *p, float h)
+{
+    float r = p->diameterCm / 2;
+    return GEOMETRY_PI * r * r * h / 1000;
+}
+
+// Segmento circular de altura h vezes o comprimento
+static float horizontal_litres(const geometry_profile_t *p, float h)
+{
+    float r = p->diameterCm / 2;
+    float c = (r - h) / r;
+    if (c > 1)
+        c = 1;
+    else if (c < -1)
+        c = -1;
+    float area = r * r * acosf(c) - (r - h) * sqrtf(fmaxf(0, 2 * r * h - h * h));
+    return area * p->lengthCm / 1000;
+}
+
+// Cone com vertice no fundo ate coneHeightCm, cilindro acima
+static float cone_bottom_litres(const geometry_profile_t *p, float h)
+{
+    float r = p->diameterCm / 2;
+    float hc = p->coneHeightCm;
+    if (h <= hc)
+    {
+        float rh = r * h / hc;
+        return GEOMETRY_PI * rh * rh * h / 3 / 1000;
+    }
+    return (GEOMETRY_PI * r * r * hc / 3 + GEOMETRY_PI * r * r * (h - hc)) / 1000;
+}
+
+bool geometry_build(geometry_lut_t *lut, const geometry_profile_t *profile)
+{
+    lut->count = 0;
+    if (profile->shape == GEOMETRY_TABLE)
+    {
+        if (profile->table == NULL || profile->tableCount < 2 || profile->tableCount > GEOMETRY_POINTS_MAX)
+            return false;
+        for (int i = 0; i < profile->tableCount; i++)
+        {
+            const geometry_point_t *point = &profile->table[i];
+            if (!(point->litres >= 0) ||
+                (i > 0 && (point->levelCm <= lut->levelCm[i - 1] || point->litres < lut->litres[i - 1])))
+                return false;
+            lut->levelCm[i] = point->levelCm;
+            lut->litres[i] = point->litres;
+        }
+        // Tabela plana daria capacidade nula e percentual indefinido
+        if (!(lut->litres[profile->tableCount - 1] > lut->litres[0]))
+            return false;
+        lut->count = profile->tableCount;
+        return true;
+    }
+
+    float (*litres)(const geometry_profile_t *, float);
+    float top;
+    switch (profile->shape)
+    {
+    case GEOMETRY_CYLINDER:
+        litres = cylinder_litres;
+        top = profile->heightCm;
+        break;
+    case GEOMETRY_HORIZONTAL_CYLINDER:
+        if (!(profile->lengthCm > 0))
+            return false;
+        litres = horizontal_litres;
+        top = profile->diameterCm;
+        break;
+    case GEOMETRY_CONE_BOTTOM:
+        if (!(profile->coneHeightCm > 0 && profile->coneHeightCm < profile->heightCm))
+            return false;
+        litres = cone_bottom_litres;
+        top = profile->heightCm;
+        break;
+    default:
+        return false;
+    }
+    if (!(profile->diameterCm > 0 && top > 0))
+        return false;
+
+    // Pontos igualmente espacados na altura; o erro da interpolacao fica
+    // abaixo de 0.1% da capacidade nas curvas do cilindro deitado e do cone
+    for (int i = 0; i < GEOMETRY_POINTS_MAX; i++)
+    {
+        float h = top * i / (GEOMETRY_POINTS_MAX - 1);
+        lut->levelCm[i] = h;
+        lut->litres[i] = litres(profile, h);
+    }
+    lut->count = GEOMETRY_POINTS_MAX;
+    return true;
+}
+
+// Indice i com x[i] <= value < x[i + 1], limitado a [0, count - 2]
+static int find_segment(const float *x, int count, float value)
+{
+    int lo = 0;
+    int hi = count - 1;
+    while (hi - lo > 1)
+    {
+        int mid = (lo + hi) / 2;
+        if (x[mid] <= value)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static float interpolate(const float *x, const float *y, int count, float value)
+{
+    if (count < 2)
+        return 0;
+    if (value <= x[0])
+        return y[0];
+    if (value >= x[count - 1])
+        return y[count - 1];
+    int i = find_segment(x, count, value);
+    float span = x[i + 1] - x[i];
+    if (span <= 0)
+        return y[i];
+    return y[i] + (y[i + 1] - y[i]) * (value - x[i]) / span;
+}
+
+float geometry_litres(const geometry_lut_t *lut, float levelCm)
+{
+    return interpolate(lut->levelCm, lut->litres, lut->count, levelCm);
+}
+
+float geometry_level(const geometry_lut_t *lut, float litres)
+{
+    return interpolate(lut->litres, lut->levelCm, lut->count, litres);
+}
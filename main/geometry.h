@@ -0,0 +1,62 @@
+#ifndef MAIN_GEOMETRY_H_
+#define MAIN_GEOMETRY_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Conversao de altura da agua em volume. O perfil do reservatorio e
+// convertido uma vez numa tabela altura -> litros com pontos crescentes;
+// cada amostra custa uma busca binaria e uma interpolacao linear.
+
+#define GEOMETRY_POINTS_MAX 64
+
+typedef enum
+{
+    GEOMETRY_CYLINDER,            // cilindro vertical (ou prisma de secao constante)
+    GEOMETRY_HORIZONTAL_CYLINDER, // cilindro deitado, altura vai de 0 ao diametro
+    GEOMETRY_CONE_BOTTOM,         // cilindro vertical com fundo conico
+    GEOMETRY_TABLE,               // tabela de arqueacao medida
+    GEOMETRY_SHAPES,
+} geometry_shape_t;
+
+typedef struct
+{
+    float levelCm;
+    float litres;
+} geometry_point_t;
+
+typedef struct
+{
+    geometry_shape_t shape;
+    float heightCm;     // altura util do cilindro vertical e do fundo conico
+    float diameterCm;
+    float lengthCm;     // cilindro deitado
+    float coneHeightCm; // fundo conico, incluido em heightCm
+    // Tabela de arqueacao (GEOMETRY_TABLE), alturas crescentes
+    const geometry_point_t *table;
+    int tableCount;
+} geometry_profile_t;
+
+typedef struct
+{
+    float levelCm[GEOMETRY_POINTS_MAX];
+    float litres[GEOMETRY_POINTS_MAX];
+    int count;
+} geometry_lut_t;
+
+// Monta a tabela; retorna false se o perfil for invalido (dimensoes nao
+// positivas, tabela com menos de dois pontos, nao crescente, com volume
+// negativo ou sem variacao de volume)
+bool geometry_build(geometry_lut_t *lut, const geometry_profile_t *profile);
+
+// Litros para a altura dada, limitada a faixa da tabela
+float geometry_litres(const geometry_lut_t *lut, float levelCm);
+// Altura para o volume dado, inversa de geometry_litres
+float geometry_level(const geometry_lut_t *lut, float litres);
+
+static inline float geometry_capacity(const geometry_lut_t *lut)
+{
+    return lut->count > 0 ? lut->litres[lut->count - 1] : 0;
+}
+
+#endif /* MAIN_GEOMETRY_H_ */
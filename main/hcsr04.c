@@ -0,0 +1,18 @@
+#include <esp32/rom/ets_sys.h>
+#include "hcsr04.h"
+
+void hcsr04_init(gpio_num_t trigger, gpio_num_t echo)
+{
+    esp_rom_gpio_pad_select_gpio(trigger);
+    esp_rom_gpio_pad_select_gpio(echo);
+    gpio_set_direction(trigger, GPIO_MODE_OUTPUT);
+    gpio_set_direction(echo, GPIO_MODE_INPUT);
+    gpio_set_level(trigger, 0);
+}
+
+void hcsr04_trigger(gpio_num_t trigger)
+{
+    gpio_set_level(trigger, 1);
+    ets_delay_us(10);
+    gpio_set_level(trigger, 0);
+}
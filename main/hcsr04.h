@@ -0,0 +1,21 @@
+#ifndef MAIN_HCSR04_H_
+#define MAIN_HCSR04_H_
+
+#include <stdint.h>
+#include <driver/gpio.h>
+
+// Velocidade do som: 0.0343 cm/us, ida e volta
+#define HCSR04_US_TO_CM(us) ((us) * 0.0343 / 2)
+#define HCSR04_CM_TO_US(cm) ((cm) * 2 / 0.0343)
+
+// Alcance do modulo; sem eco ele mantem o pino alto por ~38 ms
+#define HCSR04_MIN_CM 2
+#define HCSR04_MAX_CM 400
+// Do fim do pulso de trigger ate a subida do eco (rajada de 8 ciclos)
+#define HCSR04_SETUP_US 1000
+
+void hcsr04_init(gpio_num_t trigger, gpio_num_t echo);
+// Pulso de 10 us; a duracao do eco e medida pela interrupcao do pino echo
+void hcsr04_trigger(gpio_num_t trigger);
+
+#endif /* MAIN_HCSR04_H_ */
@@ -0,0 +1,53 @@
+#include <string.h>
+#include <esp_log.h>
+#include <sdkconfig.h>
+#include "health.h"
+
+#define HEALTH_TAG "HEALTH"
+#define HEALTH_RECOVER 3 // leituras boas seguidas para sair da falha
+
+void health_init(health_sensor_t *sensor, const char *tank, const char *sensorName, int64_t now)
+{
+    memset(sensor, 0, sizeof(health_sensor_t));
+    sensor->tank = tank;
+    sensor->sensor = sensorName;
+    sensor->faultSince = now;
+}
+
+health_status_t health_update(health_sensor_t *sensor, int64_t timestamp, uint8_t fault)
+{
+    health_status_t status;
+    if (fault == ACQ_OK)
+    {
+        sensor->faultSince = 0;
+        sensor->goodStreak++;
+        // Um sensor intermitente nao deve religar os atuadores a cada acerto
+        status = sensor->status == HEALTH_FAILED && sensor->goodStreak < HEALTH_RECOVER ? HEALTH_FAILED : HEALTH_OK;
+    }
+    else
+    {
+        sensor->goodStreak = 0;
+        if (fault == ACQ_TIMEOUT)
+            sensor->timeouts++;
+        else if (fault == ACQ_CRC)
+            sensor->crcErrors++;
+        else
+            sensor->implausible++;
+        if (sensor->faultSince == 0)
+            sensor->faultSince = timestamp;
+        bool expired = timestamp - sensor->faultSince >= (int64_t)CONFIG_APP_HEALTH_TIMEOUT_MS * 1000;
+        status = expired ? HEALTH_FAILED : HEALTH_DEGRADED;
+    }
+
+    if (status != sensor->status)
+    {
+        if (status == HEALTH_FAILED)
+            ESP_LOGE(HEALTH_TAG, "%s: sensor de %s em falha (%u sem resposta, %u CRC, %u fora da faixa)",
+                     sensor->tank, sensor->sensor, (unsigned)sensor->timeouts, (unsigned)sensor->crcErrors,
+                     (unsigned)sensor->implausible);
+        else if (sensor->status == HEALTH_FAILED)
+            ESP_LOGI(HEALTH_TAG, "%s: sensor de %s normalizado", sensor->tank, sensor->sensor);
+        sensor->status = status;
+    }
+    return status;
+}
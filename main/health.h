@@ -0,0 +1,47 @@
+#ifndef MAIN_HEALTH_H_
+#define MAIN_HEALTH_H_
+
+#include <stdint.h>
+#include "acq.h"
+
+// Bits de tank_state_t.faults. DEGRADED: leituras falhando, atuadores no
+// ultimo estado; FAILED: so falhas por CONFIG_APP_HEALTH_TIMEOUT_MS desde a
+// primeira, atuadores no estado seguro do reservatorio.
+#define HEALTH_LEVEL_DEGRADED 0x01
+#define HEALTH_LEVEL_FAILED 0x02
+#define HEALTH_TEMP_DEGRADED 0x04
+#define HEALTH_TEMP_FAILED 0x08
+#define HEALTH_STALLED 0x10 // nenhuma amostra no prazo: a aquisicao parou
+
+typedef enum
+{
+    HEALTH_OK,
+    HEALTH_DEGRADED,
+    HEALTH_FAILED,
+} health_status_t;
+
+// Supervisao de um sensor: conta as falhas por motivo e declara o sensor
+// em falha pelo tempo desde a primeira falha seguida, nao pelo numero de
+// amostras, para que o prazo valha com qualquer periodo de amostragem. O
+// prazo conta da primeira amostra falha e nao da ultima boa: com o periodo
+// longo de um nivel estavel, uma falha isolada seria declarada falha de
+// uma vez. A primeira falha acelera a amostragem (rate.c).
+typedef struct
+{
+    const char *tank; // nomes para o log
+    const char *sensor;
+    health_status_t status;
+    int64_t faultSince; // primeira falha da sequencia atual, 0 sem falha
+    uint32_t goodStreak;
+    uint32_t timeouts;
+    uint32_t crcErrors;
+    uint32_t implausible;
+} health_sensor_t;
+
+// now: inicio do prazo da primeira leitura, esp_timer_get_time(); ate a
+// primeira leitura boa o sensor conta como em falha desde now
+void health_init(health_sensor_t *sensor, const char *tank, const char *sensorName, int64_t now);
+// fault: acq_fault_t da leitura do ciclo
+health_status_t health_update(health_sensor_t *sensor, int64_t timestamp, uint8_t fault);
+
+#endif /* MAIN_HEALTH_H_ */
@@ -0,0 +1,54 @@
+#include <freertos/FreeRTOS.h>
+#include "history.h"
+#include "fixfmt.h"
+
+static history_sample_t samples[CONFIG_APP_HISTORY_SAMPLES];
+static uint32_t head;
+static portMUX_TYPE historyMux = portMUX_INITIALIZER_UNLOCKED;
+
+void history_add(const state_t *state, int tank)
+{
+    const tank_state_t *t = &state->tanks[tank];
+    history_sample_t sample = {
+        .time = (uint32_t)(state->timestamp / 1000000),
+        .level = (int16_t)fix_from_float(t->waterPercent, 2),
+        .temperature = (int16_t)fix_from_float(t->waterTemperature, 2),
+        .rate = (int16_t)fix_from_float(t->levelRate, 2),
+        .flags = (t->pumpOn ? HISTORY_PUMP : 0) | (t->heaterOn ? HISTORY_HEATER : 0) | tank << HISTORY_TANK_SHIFT,
+        .alarms = t->alarms,
+    };
+    portENTER_CRITICAL(&historyMux);
+    samples[head % CONFIG_APP_HISTORY_SAMPLES] = sample;
+    head++;
+    portEXIT_CRITICAL(&historyMux);
+}
+
+uint32_t history_head(void)
+{
+    portENTER_CRITICAL(&historyMux);
+    uint32_t seq = head;
+    portEXIT_CRITICAL(&historyMux);
+    return seq;
+}
+
+uint32_t history_tail(void)
+{
+    portENTER_CRITICAL(&historyMux);
+    uint32_t seq = head > CONFIG_APP_HISTORY_SAMPLES ? head - CONFIG_APP_HISTORY_SAMPLES : 0;
+    portEXIT_CRITICAL(&historyMux);
+    return seq;
+}
+
+// Retorna false se a amostra ainda nao existe ou ja foi sobrescrita
+bool history_get(uint32_t seq, history_sample_t *sample)
+{
+    bool found = false;
+    portENTER_CRITICAL(&historyMux);
+    if (seq < head && head - seq <= CONFIG_APP_HISTORY_SAMPLES)
+    {
+        *sample = samples[seq % CONFIG_APP_HISTORY_SAMPLES];
+        found = true;
+    }
+    portEXIT_CRITICAL(&historyMux);
+    return found;
+}
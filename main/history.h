@@ -0,0 +1,37 @@
+#ifndef MAIN_HISTORY_H_
+#define MAIN_HISTORY_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "state.h"
+
+#define HISTORY_PUMP 0x01
+#define HISTORY_HEATER 0x02
+// Reservatorio da amostra (a partir de 0) nos bits altos de flags
+#define HISTORY_TANK_SHIFT 4
+#define HISTORY_TANK(flags) ((flags) >> HISTORY_TANK_SHIFT)
+
+// Amostra compacta guardada no historico
+typedef struct
+{
+    uint32_t time;       // s desde o boot
+    int16_t level;       // % do volume x100
+    int16_t temperature; // C x100
+    int16_t rate;        // %/min x100
+    uint8_t flags;       // HISTORY_* e o reservatorio
+    uint8_t alarms;      // ANOMALY_*
+} history_sample_t;
+
+// 12 bytes por amostra: as 720 amostras padrao ocupam 8640 bytes
+_Static_assert(sizeof(history_sample_t) == 12, "amostra do historico mudou de tamanho");
+
+// Buffer circular em RAM com as ultimas CONFIG_APP_HISTORY_SAMPLES
+// amostras. Cada amostra recebe um numero de sequencia crescente; cada
+// leitor guarda o proprio cursor e detecta amostras ja sobrescritas.
+// Os reservatorios dividem o buffer: cada ciclo grava uma amostra de cada.
+void history_add(const state_t *state, int tank);
+uint32_t history_head(void); // sequencia da proxima amostra
+uint32_t history_tail(void); // sequencia da amostra mais antiga disponivel
+bool history_get(uint32_t seq, history_sample_t *sample);
+
+#endif /* MAIN_HISTORY_H_ */
@@ -0,0 +1,154 @@
+#include <sdkconfig.h>
+#if CONFIG_APP_HTTP
+#include <stdio.h>
+#include <stdlib.h>
+#include <esp_log.h>
+#include <esp_http_server.h>
+#include "http.h"
+#include "history.h"
+#include "state.h"
+#include "tank.h"
+#include "wifi.h"
+
+#define HTTP_TAG "HTTP"
+#define HTTP_CHUNK 1024
+#define HTTP_SAMPLE_MAX 64 // maior texto de uma amostra em JSON
+#define HTTP_TANK_MAX 256  // maior texto de um reservatorio em /api/state
+
+extern const char dashboardStart[] asm("_binary_dashboard_html_start");
+extern const char dashboardEnd[] asm("_binary_dashboard_html_end");
+
+static esp_err_t dashboard_get(httpd_req_t *req)
+{
+    httpd_resp_set_type(req, "text/html");
+    // EMBED_TXTFILES acrescenta um '\0' que nao faz parte da pagina
+    return httpd_resp_send(req, dashboardStart, dashboardEnd - dashboardStart - 1);
+}
+
+static esp_err_t state_get_handler(httpd_req_t *req)
+{
+    state_t state;
+    state_get(&state);
+    char json[64 + HTTP_TANK_MAX * CONFIG_APP_TANK_COUNT];
+    int len = snprintf(json, sizeof(json), "{\"time\":%u,\"tanks\":[", (unsigned)(state.timestamp / 1000000));
+    for (int i = 0; i < CONFIG_APP_TANK_COUNT; i++)
+    {
+        const tank_state_t *tank = &state.tanks[i];
+        len += snprintf(&json[len], sizeof(json) - len,
+                        "%s{\"name\":\"%s\",\"level\":%.2f,\"litres\":%.1f,\"capacity\":%.1f,"
+                        "\"distance\":%.2f,\"temperature\":%.2f,"
+                        "\"rate\":%.2f,\"eta\":%d,\"pump\":%d,\"heater\":%d,\"alarms\":%u,\"faults\":%u,"
+                        "\"capacityLimit\":%d,\"temperatureLimit\":%.2f}",
+                        i > 0 ? "," : "", tankConfigs[i].name, tank->waterPercent, tank->waterLitres,
+                        tank->capacityLitres, tank->waterDistance,
+                        tank->waterTemperature, tank->levelRate, (int)tank->etaSeconds, tank->pumpOn,
+                        tank->heaterOn, tank->alarms, tank->faults, tank->storageCapacityLimit, tank->temperatureLimit);
+    }
+    len += snprintf(&json[len], sizeof(json) - len, "]}");
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_send(req, json, len);
+}
+
+// Primeira sequencia pedida em ?from=, limitada ao que ainda esta no historico
+static uint32_t query_from(httpd_req_t *req)
+{
+    char query[32];
+    char value[16];
+    uint32_t tail = history_tail();
+    uint32_t from = tail;
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+        httpd_query_key_value(query, "from", value, sizeof(value)) == ESP_OK)
+        from = strtoul(value, NULL, 10);
+    return from < tail ? tail : from;
+}
+
+static esp_err_t history_get_handler(httpd_req_t *req)
+{
+    char chunk[HTTP_CHUNK];
+    uint32_t seq = query_from(req);
+    uint32_t head = history_head();
+    int len = snprintf(chunk, sizeof(chunk), "{\"head\":%u,\"samples\":[", (unsigned)head);
+
+    httpd_resp_set_type(req, "application/json");
+    for (bool first = true; seq < head; seq++)
+    {
+        history_sample_t s;
+        if (!history_get(seq, &s))
+            continue;
+        if (len + HTTP_SAMPLE_MAX > (int)sizeof(chunk))
+        {
+            if (httpd_resp_send_chunk(req, chunk, len) != ESP_OK)
+                return ESP_FAIL;
+            len = 0;
+        }
+        len += snprintf(&chunk[len], sizeof(chunk) - len, "%s[%u,%u,%d,%d,%d,%u,%u]", first ? "" : ",",
+                        (unsigned)seq, (unsigned)s.time, s.level, s.temperature, s.rate, s.flags, s.alarms);
+        first = false;
+    }
+    len += snprintf(&chunk[len], sizeof(chunk) - len, "]}");
+    if (httpd_resp_send_chunk(req, chunk, len) != ESP_OK)
+        return ESP_FAIL;
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+// Registros history_sample_t crus, na ordem de memoria do ESP32 (little
+// endian). O registro i e a sequencia X-History-First + i, entao a resposta
+// termina no primeiro registro sobrescrito durante o envio; o cliente
+// continua a partir de X-History-First mais os registros recebidos.
+static esp_err_t history_bin_handler(httpd_req_t *req)
+{
+    history_sample_t chunk[HTTP_CHUNK / sizeof(history_sample_t)];
+    uint32_t seq = query_from(req);
+    uint32_t head = history_head();
+    char first[12];
+    snprintf(first, sizeof(first), "%u", (unsigned)seq);
+
+    httpd_resp_set_type(req, "application/octet-stream");
+    httpd_resp_set_hdr(req, "X-History-First", first);
+    size_t count = 0;
+    for (; seq < head; seq++)
+    {
+        if (!history_get(seq, &chunk[count]))
+            break;
+        if (++count == sizeof(chunk) / sizeof(chunk[0]))
+        {
+            if (httpd_resp_send_chunk(req, (const char *)chunk, count * sizeof(chunk[0])) != ESP_OK)
+                return ESP_FAIL;
+            count = 0;
+        }
+    }
+    if (count > 0 && httpd_resp_send_chunk(req, (const char *)chunk, count * sizeof(chunk[0])) != ESP_OK)
+        return ESP_FAIL;
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+static const httpd_uri_t handlers[] = {
+    {.uri = "/", .method = HTTP_GET, .handler = dashboard_get},
+    {.uri = "/api/state", .method = HTTP_GET, .handler = state_get_handler},
+    {.uri = "/api/history", .method = HTTP_GET, .handler = history_get_handler},
+    {.uri = "/api/history.bin", .method = HTTP_GET, .handler = history_bin_handler},
+};
+
+void http_start(void)
+{
+    if (!wifi_start())
+        return;
+
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port = CONFIG_APP_HTTP_PORT;
+    // Os blocos de resposta ficam na pilha do servidor
+    config.stack_size = 4096 + HTTP_CHUNK * 2;
+    config.core_id = CONFIG_APP_UI_CORE;
+    config.lru_purge_enable = true;
+
+    httpd_handle_t server = NULL;
+    if (httpd_start(&server, &config) != ESP_OK)
+    {
+        ESP_LOGE(HTTP_TAG, "Falha ao iniciar o servidor");
+        return;
+    }
+    for (size_t i = 0; i < sizeof(handlers) / sizeof(handlers[0]); i++)
+        httpd_register_uri_handler(server, &handlers[i]);
+    ESP_LOGI(HTTP_TAG, "Painel na porta %d", CONFIG_APP_HTTP_PORT);
+}
+#endif
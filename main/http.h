@@ -0,0 +1,13 @@
+#ifndef MAIN_HTTP_H_
+#define MAIN_HTTP_H_
+
+// Painel HTTP na porta CONFIG_APP_HTTP_PORT:
+//   GET /                      pagina estatica gravada na flash
+//   GET /api/state             estado atual em JSON, um objeto por reservatorio
+//   GET /api/history?from=N    historico a partir da sequencia N em JSON
+//   GET /api/history.bin?from=N  o mesmo em registros history_sample_t
+// As respostas de historico sao enviadas em blocos (chunked) direto do
+// buffer circular, sem montar a resposta inteira na RAM.
+void http_start(void);
+
+#endif /* MAIN_HTTP_H_ */
@@ -0,0 +1,69 @@
+#include "level.h"
+
+// Vazoes menores que isto sao tratadas como nivel estavel
+#define LEVEL_MIN_RATE 0.05f // %/min
+
+void level_init(level_est_t *est, float rateNoise, float levelNoise)
+{
+    est->rateNoise = rateNoise;
+    est->levelNoise = levelNoise;
+    est->primed = false;
+}
+
+void level_update(level_est_t *est, int64_t timestamp, float percent)
+{
+    if (!est->primed)
+    {
+        // Nivel conhecido pela medida, vazao ainda desconhecida
+        est->level = percent;
+        est->rate = 0;
+        est->p[0][0] = est->levelNoise;
+        est->p[0][1] = 0;
+        est->p[1][0] = 0;
+        est->p[1][1] = 100;
+        est->timestamp = timestamp;
+        est->primed = true;
+        return;
+    }
+
+    // Predicao: x = F x, P = F P F' + Q, com F = [1 dt; 0 1]
+    float dt = (timestamp - est->timestamp) / 60e6f;
+    est->timestamp = timestamp;
+    est->level += est->rate * dt;
+    float p00 = est->p[0][0] + dt * (est->p[0][1] + est->p[1][0]) + dt * dt * est->p[1][1];
+    float p01 = est->p[0][1] + dt * est->p[1][1];
+    float p10 = est->p[1][0] + dt * est->p[1][1];
+    float p11 = est->p[1][1];
+    float q = est->rateNoise;
+    p00 += q * dt * dt * dt / 3;
+    p01 += q * dt * dt / 2;
+    p10 += q * dt * dt / 2;
+    p11 += q * dt;
+
+    // Correcao com a medida do nivel, H = [1 0]
+    float innovation = percent - est->level;
+    float s = p00 + est->levelNoise;
+    float k0 = p00 / s;
+    float k1 = p10 / s;
+    est->level += k0 * innovation;
+    est->rate += k1 * innovation;
+    est->p[0][0] = (1 - k0) * p00;
+    est->p[0][1] = (1 - k0) * p01;
+    est->p[1][0] = p10 - k1 * p00;
+    est->p[1][1] = p11 - k1 * p01;
+}
+
+float level_predict(const level_est_t *est, float seconds)
+{
+    return est->level + est->rate * seconds / 60;
+}
+
+int32_t level_eta_s(const level_est_t *est, float target)
+{
+    if (!est->primed || (est->rate > -LEVEL_MIN_RATE && est->rate < LEVEL_MIN_RATE))
+        return -1;
+    float minutes = (target - est->level) / est->rate;
+    if (minutes < 0)
+        return -1;
+    return (int32_t)(minutes * 60);
+}
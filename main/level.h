@@ -0,0 +1,30 @@
+#ifndef MAIN_LEVEL_H_
+#define MAIN_LEVEL_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Filtro de Kalman de dois estados (nivel e vazao) com modelo de
+// velocidade constante. Cada amostra custa O(1) e nao guarda historico.
+typedef struct
+{
+    float level;      // %
+    float rate;       // %/min, positivo enchendo
+    float p[2][2];    // covariancia do erro
+    float rateNoise;  // densidade espectral da variacao da vazao, (%/min)^2/min
+    float levelNoise; // variancia da medida, %^2
+    int64_t timestamp;
+    bool primed;
+} level_est_t;
+
+void level_init(level_est_t *est, float rateNoise, float levelNoise);
+void level_update(level_est_t *est, int64_t timestamp, float percent);
+
+// Nivel previsto daqui a seconds segundos, mantida a vazao atual
+float level_predict(const level_est_t *est, float seconds);
+
+// Segundos ate o nivel atingir target na vazao atual, -1 se nao estiver
+// se aproximando dele
+int32_t level_eta_s(const level_est_t *est, float target);
+
+#endif /* MAIN_LEVEL_H_ */
@@ -1,41 +1,62 @@
 #include <stdio.h>
+#include <math.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <esp_err.h>
 #include <esp_log.h>
+#include <esp_timer.h>
 #include <driver/gpio.h>
 #include "ds18b20.h"
-#include "esp_timer.h"
 #include "ssd1306.h"
+#include "widgets.h"
+#include "fixfmt.h"
+#include "diag.h"
+#include "trace.h"
+#include "sched.h"
+#include "acq.h"
+#include "state.h"
+#include "power.h"
+#include "rate.h"
+#include "level.h"
+#include "anomaly.h"
+#include "health.h"
+#include "modbus_uart.h"
+#include "history.h"
+#include "telemetry.h"
+#include "http.h"
+#include "binlog.h"
+#include "tank.h"
+#include "console.h"
+#include "eventlog.h"
 #include <string.h>
 
-#define TRIGGER_PIN GPIO_NUM_13 // pino trigger do sensor ultrassonico
-#define ECHO_PIN GPIO_NUM_35    // pino echo do sensor ultrassonico
-#define WATER_TANK_HEIGHT_CM 20 // altura maxima do reservatorio
-#define PIN_DS18B20 GPIO_NUM_32 // pino data do sensor de temp
-#define DISTANCE_CONTROL GPIO_NUM_10
-#define TEMPERATURE_CONTROL GPIO_NUM_9
+#define PIN_DS18B20 GPIO_NUM_32 // barramento 1-Wire compartilhado pelos reservatorios
 #define DECREASE_BUTTON GPIO_NUM_14
 #define INCREMENT_BUTTON GPIO_NUM_26
 #define CHANGE_MODE_BUTTON GPIO_NUM_27
 #define DEBOUNCE_MS 200
-#define READ_SENSORS_DELAY 2000
+#define READ_SENSORS_DELAY CONFIG_APP_SENSOR_PERIOD_MS
+#define BUTTON_POLL_MS 50
+#define WATCHDOG_PERIOD_MS 1000
+#define LEVEL_RATE_NOISE 0.5f  // (%/min)^2/min: quao rapido a vazao pode mudar
+#define LEVEL_MEASURE_NOISE 1.0f // %^2: ruido da medida ultrassonica
+#define FINE_HYSTERESIS 0.5f     // C alem de CONFIG_APP_ACQ_FINE_MARGIN para voltar a resolucao baixa
 
 #define DS18B20_TAG "DS18B20"
 #define HCSR04_TAG "HCSR04"
+#define RATE_TAG "RATE"
+#define HEALTH_TAG "HEALTH"
 #define DECREASE_BUTTON_TAG "DECREASE"
 #define INCREMENT_BUTTON_TAG "INCREMENT"
 #define CHANGE_MODE_BUTTON_TAG "CHANGE_MODE"
 
 #define TEMPERATURE_MODE 1
 #define DISTANCE_MODE 2
+#define DIAG_MODE 3
+#define EVENT_MODE 4
 
-#define delay(value) vTaskDelay(value / portTICK_PERIOD_MS)
-
-volatile double temperatureLimit = 10;
-volatile int storageCapacityLimit = 10;
-volatile double waterDistance = 0;
-volatile float waterTemperature = 0;
+// Renovado quando o parametro muda; lido pelas ISRs dos botoes
+static volatile TickType_t debounceTicks = pdMS_TO_TICKS(DEBOUNCE_MS);
 
 TickType_t last_tick_decrease = 0;
 volatile bool decrease_button = false;
@@ -48,136 +69,382 @@ volatile bool change_mode_button = false;
 
 static SSD1306_t dev;
 
-volatile int currentMode = DISTANCE_MODE;
+// Copia do estado usada pelos widgets, renovada a cada atualizacao da tela,
+// e o reservatorio selecionado dentro dela
+static state_t uiState;
+static tank_state_t uiTank;
 
-double calculateWaterPercent()
+// Com um reservatorio so o titulo nao muda
+int format_tank_title(char *buf, size_t size, const volatile void *value)
 {
-    return ((WATER_TANK_HEIGHT_CM - waterDistance) / WATER_TANK_HEIGHT_CM) * 100;
+    if (TANK_COUNT == 1)
+        return snprintf(buf, size, "Niveis atuais");
+    return snprintf(buf, size, "%s", tankConfigs[*(const volatile int *)value].name);
 }
 
-void write_text()
+// Percentual do volume seguido dos litros
+int format_water_percent(char *buf, size_t size, const volatile void *value)
 {
-    char strTemperature[12];
-    char strDistance[12];
-    char strTemperatureLimit[12];
-    char strDistanceLimit[12];
+    int len = fmt_fixed(buf, size, fix_from_float(*(const volatile float *)value, 1), 1, " % ", 0);
+    return len + snprintf(&buf[len], size - len, "%d L", (int)(uiTank.waterLitres + 0.5f));
+}
 
-    float waterPercentage = calculateWaterPercent();
+int format_temperature(char *buf, size_t size, const volatile void *value)
+{
+    return fmt_fixed(buf, size, fix_from_float(*(const volatile float *)value, 2), 2, " C", 0);
+}
 
-    // Mostrar no display valores atuais de temperatura e capacidade
-    sprintf(strDistance, "%.2f", waterPercentage);
-    sprintf(strTemperature, "%.2f", waterTemperature);
-    strcat(strDistance, " %");
-    strcat(strTemperature, " C");
-    ssd1306_display_text(&dev, 0, "Niveis atuais", 14, false);
-    ssd1306_display_text(&dev, 1, strDistance, strlen(strDistance), false);
-    ssd1306_display_text(&dev, 2, strTemperature, strlen(strTemperature), false);
+int format_distance_limit(char *buf, size_t size, const volatile void *value)
+{
+    return fmt_fixed(buf, size, *(const volatile int *)value, 0, uiState.mode == DISTANCE_MODE ? " % <-" : " %", 0);
+}
 
+int format_temperature_limit(char *buf, size_t size, const volatile void *value)
+{
+    return fmt_fixed(buf, size, fix_from_float(*(const volatile float *)value, 2), 2, uiState.mode == TEMPERATURE_MODE ? " C <-" : " C", 0);
+}
+
+int format_level_rate(char *buf, size_t size, const volatile void *value)
+{
+    return fmt_fixed(buf, size, fix_from_float(*(const volatile float *)value, 2), 2, " %/m", 0);
+}
+
+// Tempo ate encher ou esvaziar, em minutos ou horas e minutos.
+// Falhas de sensor e alarmes de anomalia ocupam a mesma linha.
+int format_eta(char *buf, size_t size, const volatile void *value)
+{
+    if (uiTank.faults & HEALTH_STALLED)
+        return snprintf(buf, size, "AQUISICAO PARADA");
+    if (uiTank.faults & HEALTH_LEVEL_FAILED)
+        return snprintf(buf, size, "FALHA SENS NIVEL");
+    if (uiTank.faults & HEALTH_TEMP_FAILED)
+        return snprintf(buf, size, "FALHA SENS TEMP");
+    if (uiTank.alarms & ANOMALY_LEAK)
+        return snprintf(buf, size, "ALARME VAZAMENTO");
+    if (uiTank.alarms & ANOMALY_DRY_RUN)
+        return snprintf(buf, size, "ALARME BOMBA");
+    if (uiTank.alarms & ANOMALY_LOW_LEVEL)
+        return snprintf(buf, size, "ALARME NIVEL");
+    int32_t eta = *(const volatile int32_t *)value;
+    if (eta < 0)
+        return snprintf(buf, size, "Nivel estavel");
+    const char *label = uiTank.levelRate > 0 ? "Cheio em" : "Vazio em";
+    int32_t minutes = (eta + 59) / 60;
+    if (minutes < 60)
+        return snprintf(buf, size, "%s %dm", label, (int)minutes);
+    if (minutes < 100 * 60)
+        return snprintf(buf, size, "%s %dh%02d", label, (int)(minutes / 60), (int)(minutes % 60));
+    return snprintf(buf, size, "%s +99h", label);
+}
+
+static widget_t mainWidgets[] = {
+    // Mostrar no display valores atuais de temperatura e capacidade
+    WIDGET_FIELD(0, NULL, format_tank_title, &uiState.tank),
+    WIDGET_FIELD(1, NULL, format_water_percent, &uiTank.waterPercent),
+    WIDGET_FIELD(2, NULL, format_temperature, &uiTank.waterTemperature),
+    WIDGET_FIELD(3, "Vazao ", format_level_rate, &uiTank.levelRate),
     // Mostrar no display valores limites para acionamento dos atuadores
-    sprintf(strDistanceLimit, "%d", storageCapacityLimit);
-    sprintf(strTemperatureLimit, "%.2f", temperatureLimit);
-    if (currentMode == DISTANCE_MODE)
+    WIDGET_LABEL(4, "Configuracoes"),
+    WIDGET_FIELD(5, NULL, format_distance_limit, &uiTank.storageCapacityLimit),
+    WIDGET_FIELD(6, NULL, format_temperature_limit, &uiTank.temperatureLimit),
+    WIDGET_FIELD(7, NULL, format_eta, &uiTank.etaSeconds),
+};
+
+static screen_t mainScreen;
+
+// Chamado por screen_update com o lock da tela: todos os widgets
+// formatam o mesmo snapshot
+static void refresh_ui_state(void)
+{
+    state_get(&uiState);
+    uiTank = uiState.tanks[uiState.tank];
+#if CONFIG_APP_DIAG_SCREEN
+    if (uiState.mode == DIAG_MODE)
+        diag_refresh();
+#endif
+}
+
+// Redesenha apenas os campos cujo texto mudou
+void write_text()
+{
+    if (!power_display_awake())
+        return;
+    TRACE_BEGIN(TRACE_DISPLAY_UPDATE, 0);
+    screen_update(&mainScreen);
+    TRACE_END(TRACE_DISPLAY_UPDATE, 0);
+}
+
+// Repassa o estado as interfaces externas (imagem de registradores Modbus)
+static void publish_state(const state_t *snapshot)
+{
+#if CONFIG_APP_MODBUS
+    modbus_publish(snapshot);
+#endif
+}
+
+// Configuracao alterada por uma interface remota
+static void on_remote_change(void)
+{
+    state_t snapshot;
+    state_get(&snapshot);
+    debounceTicks = pdMS_TO_TICKS(snapshot.debounceMs);
+    publish_state(&snapshot);
+    write_text();
+}
+
+void control_setup()
+{
+    for (int i = 0; i < TANK_COUNT; i++)
+        tank_setup(&tankConfigs[i]);
+}
+
+// Retorna se a bomba ficou ligada. Percentuais sao do volume; predicted e
+// o nivel esperado na proxima amostra: enchendo, a bomba para antes de
+// passar do limite.
+bool distance_control(const tank_config_t *config, float distance, float waterPercentage, float predicted,
+                      const tank_state_t *tank)
+{
+    float limit = state_capacity_limit(tank);
+    bool pumpOn = config->pump != GPIO_NUM_NC && waterPercentage < limit && predicted < limit;
+
+    if (pumpOn)
+        ESP_LOGW(HCSR04_TAG, "%s: bomba acionada!", config->name);
+    tank_set_pump(config, pumpOn);
+
+#if !CONFIG_APP_BINLOG
+    // Com a telemetria binaria as medidas saem por ela, sem formatar texto aqui
+    char strValue[16];
+    fmt_fixed(strValue, sizeof(strValue), fix_from_float(distance, 2), 2, " cm", 0);
+    ESP_LOGW(HCSR04_TAG, "%s: distancia %s", config->name, strValue);
+    fmt_fixed(strValue, sizeof(strValue), fix_from_float(waterPercentage, 2), 2, " %", 0);
+    ESP_LOGW(HCSR04_TAG, "%s: porcentagem de agua %s\n", config->name, strValue);
+#endif
+    return pumpOn;
+}
+
+// Retorna se a resistencia ficou ligada; sem resistencia fica sempre desligada
+bool temperature_control(const tank_config_t *config, float current_temp, const tank_state_t *tank)
+{
+    bool heaterOn = config->heater != GPIO_NUM_NC && current_temp < tank->temperatureLimit;
+
+    if (heaterOn)
+        ESP_LOGE(DS18B20_TAG, "%s: resistência acionada", config->name);
+    tank_set_heater(config, heaterOn);
+
+#if !CONFIG_APP_BINLOG
+    char strValue[16];
+    fmt_fixed(strValue, sizeof(strValue), fix_from_float(current_temp, 2), 2, " C", 0);
+    ESP_LOGE(DS18B20_TAG, "%s: temperature %s\n", config->name, strValue);
+#endif
+    return heaterOn;
+}
+
+static sched_task_t acqTask;
+static tank_t tanks[TANK_COUNT];
+static uint32_t samplePeriodMs = READ_SENSORS_DELAY;
+
+// Malhas de um reservatorio; retorna em *tank as medidas e atuadores do ciclo
+static void control_tank(tank_t *t, int64_t timestamp, const acq_reading_t *reading,
+                         const state_t *current, tank_state_t *tank)
+{
+    // Parametros do console valem a partir deste ciclo
+    t->rateCtl.minMs = current->sampleMinMs;
+    t->rateCtl.maxMs = current->sampleMaxMs > current->sampleMinMs ? current->sampleMaxMs : current->sampleMinMs;
+    t->levelEst.rateNoise = current->levelRateNoise;
+    t->levelEst.levelNoise = current->levelMeasureNoise;
+
+    // Perfil alterado pelo console vale a partir deste ciclo
+    acq_set_range(t->index, tank->tankHeightCm);
+    bool haveGeometry = tank_geometry_update(t, tank) && geometry_capacity(&t->lut) > 0;
+    health_status_t level = health_update(&t->levelHealth, timestamp, reading->distanceFault);
+    if (reading->distanceValid && haveGeometry)
     {
-        strcat(strDistanceLimit, " % <-");
-        strcat(strTemperatureLimit, " C");
+        // O filtro trabalha em % do volume: a vazao da bomba e constante em
+        // volume, nao em altura, quando a secao do reservatorio varia
+        float litres = geometry_litres(&t->lut, tank->tankHeightCm - reading->distanceCm);
+        float capacity = geometry_capacity(&t->lut);
+        float percent = litres / capacity * 100;
+        level_update(&t->levelEst, timestamp, percent);
+        // Vazao do intervalo que terminou, com a bomba no estado de entao
+        tank->alarms = anomaly_update(&t->anomalyDet, tank->pumpOn, t->levelEst.rate);
+        if (tank->lowLevelLitres > 0 && litres < tank->lowLevelLitres)
+            tank->alarms |= ANOMALY_LOW_LEVEL;
+        // A bomba fica no estado escolhido ate a proxima amostra
+        float predicted = level_predict(&t->levelEst, samplePeriodMs / 1000.0f);
+        if (level != HEALTH_FAILED)
+            tank->pumpOn = distance_control(t->config, reading->distanceCm, percent, predicted, tank);
+
+        tank->waterDistance = reading->distanceCm;
+        tank->waterPercent = percent;
+        tank->waterLitres = litres;
+        tank->capacityLitres = capacity;
+        tank->levelRate = t->levelEst.rate;
+        tank->etaSeconds = level_eta_s(&t->levelEst, t->levelEst.rate > 0 ? 100 : 0);
     }
-    else
+    // Em falha a malha nao volta a comandar ate o sensor se firmar, mesmo
+    // que uma leitura boa chegue
+    if (level == HEALTH_FAILED)
     {
-        strcat(strDistanceLimit, " %");
-        strcat(strTemperatureLimit, " C <-");
+        tank->pumpOn = t->config->pumpSafe && t->config->pump != GPIO_NUM_NC;
+        tank_set_pump(t->config, tank->pumpOn);
     }
 
-    ssd1306_display_text(&dev, 4, "Configuracoes", 14, false);
-    ssd1306_display_text(&dev, 5, strDistanceLimit, strlen(strDistanceLimit), false);
-    ssd1306_display_text(&dev, 6, strTemperatureLimit, strlen(strTemperatureLimit), false);
-}
+    // Sem resistencia a temperatura e so informativa
+    health_status_t temperature = HEALTH_OK;
+    if (t->config->heater != GPIO_NUM_NC)
+        temperature = health_update(&t->temperatureHealth, timestamp, reading->temperatureFault);
+    if (reading->temperatureValid)
+    {
+        if (temperature != HEALTH_FAILED)
+            tank->heaterOn = temperature_control(t->config, reading->temperature, tank);
+        tank->waterTemperature = reading->temperature;
+    }
+    if (temperature == HEALTH_FAILED)
+    {
+        tank->heaterOn = t->config->heaterSafe;
+        tank_set_heater(t->config, tank->heaterOn);
+    }
 
-void hcsr04_task(void *pvParameters)
-{
-    esp_rom_gpio_pad_select_gpio(TRIGGER_PIN);
-    esp_rom_gpio_pad_select_gpio(ECHO_PIN);
-    esp_rom_gpio_pad_select_gpio(DISTANCE_CONTROL);
-    gpio_set_direction(TRIGGER_PIN, GPIO_MODE_OUTPUT);
-    gpio_set_direction(ECHO_PIN, GPIO_MODE_INPUT);
-    gpio_set_direction(DISTANCE_CONTROL, GPIO_MODE_OUTPUT);
-
-    while (1)
+    // Resolucao maxima so perto do limite da resistencia, ou sem leitura
+    // para saber a distancia ate ele
+    if (reading->temperatureValid)
     {
-        // Pulso no pino de trigger
-        gpio_set_level(TRIGGER_PIN, 1);
-        delay(10);
-        gpio_set_level(TRIGGER_PIN, 0);
+        float margin = fabsf(reading->temperature - tank->temperatureLimit);
+        t->fineTemperature = margin < CONFIG_APP_ACQ_FINE_MARGIN + (t->fineTemperature ? FINE_HYSTERESIS : 0);
+    }
+    else
+    {
+        t->fineTemperature = true;
+    }
+    acq_set_precision(t->index, t->config->heater != GPIO_NUM_NC && t->fineTemperature);
+
+    tank->faults = (level == HEALTH_DEGRADED ? HEALTH_LEVEL_DEGRADED : 0) |
+                   (level == HEALTH_FAILED ? HEALTH_LEVEL_FAILED : 0) |
+                   (temperature == HEALTH_DEGRADED ? HEALTH_TEMP_DEGRADED : 0) |
+                   (temperature == HEALTH_FAILED ? HEALTH_TEMP_FAILED : 0);
+    if (tank->faults & (HEALTH_LEVEL_FAILED | HEALTH_TEMP_FAILED))
+        tank->alarms |= ANOMALY_SENSOR;
+    else
+        tank->alarms &= ~ANOMALY_SENSOR;
+}
 
-        // Aguardar resposta no pino echo
-        int64_t pulse_start = 0;
-        int64_t pulse_end = 0;
+// Prazo da proxima amostra, em ms de esp_timer_get_time() truncados para
+// 32 bits (comparados pela diferenca). Renovado a cada amostra.
+static volatile uint32_t sampleDueMs;
 
-        while (gpio_get_level(ECHO_PIN) == 0)
-        {
-            pulse_start = esp_timer_get_time();
-        }
-        while (gpio_get_level(ECHO_PIN) == 1)
-        {
-            pulse_end = esp_timer_get_time();
-        }
+static uint32_t now_ms(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
 
-        // Calcular a duração do pulso em microssegundos
-        int64_t pulse_duration = pulse_end - pulse_start;
+// Vigia da aquisicao, rodando no outro core: sem amostras nenhuma malha
+// percebe um sensor que sumiu, entao os atuadores vao para o estado seguro
+// no maximo CONFIG_APP_HEALTH_TIMEOUT_MS depois do prazo
+static void watchdog_task(void *arg)
+{
+    if ((int32_t)(now_ms() - sampleDueMs) < CONFIG_APP_HEALTH_TIMEOUT_MS)
+        return;
 
-        // Calcular a distância em centímetros
-        waterDistance = pulse_duration * 0.0343 / 2; // Fórmula para calcular a distância
-        float waterPercentage = calculateWaterPercent();
+    tank_state_t safe[TANK_COUNT];
+    for (int i = 0; i < TANK_COUNT; i++)
+    {
+        const tank_config_t *config = &tankConfigs[i];
+        safe[i].pumpOn = config->pumpSafe && config->pump != GPIO_NUM_NC;
+        safe[i].heaterOn = config->heaterSafe && config->heater != GPIO_NUM_NC;
+        tank_set_pump(config, safe[i].pumpOn);
+        tank_set_heater(config, safe[i].heaterOn);
+    }
 
-        if (waterPercentage < storageCapacityLimit)
-        {
-            ESP_LOGW(HCSR04_TAG, "Bomba acionada!");
-            gpio_set_level(DISTANCE_CONTROL, 0);
-        }
-        else
-        {
-            gpio_set_level(DISTANCE_CONTROL, 1);
-        }
+    tank_state_t before[TANK_COUNT];
+    state_t *state = state_write_begin();
+    bool reported = (state->tanks[0].faults & HEALTH_STALLED) != 0;
+    for (int i = 0; i < TANK_COUNT; i++)
+    {
+        tank_state_t *tank = &state->tanks[i];
+        before[i] = *tank;
+        tank->pumpOn = safe[i].pumpOn;
+        tank->heaterOn = safe[i].heaterOn;
+        tank->faults |= HEALTH_STALLED;
+        tank->alarms |= ANOMALY_SENSOR;
+    }
+    state_write_end();
 
-        ssd1306_clear_line(&dev, 1, false);
+    if (!reported)
+    {
+        ESP_LOGE(HEALTH_TAG, "Nenhuma amostra no prazo: atuadores no estado seguro");
+        state_t snapshot;
+        state_get(&snapshot);
+        for (int i = 0; i < TANK_COUNT; i++)
+            eventlog_compare(i, &before[i], &snapshot.tanks[i]);
+        publish_state(&snapshot);
         write_text();
-
-        ESP_LOGW(HCSR04_TAG, "Distancia: %.2f cm", waterDistance);
-        ESP_LOGW(HCSR04_TAG, "Porcentagem de agua: %.2f %%\n", waterPercentage);
-        delay(READ_SENSORS_DELAY);
     }
 }
 
-void temperature_task(void *pvParameters)
+// Chamado pela tarefa de aquisicao com as medidas do ciclo
+void on_sample(const acq_sample_t *sample)
 {
-    ds18b20_init(PIN_DS18B20);
-    esp_rom_gpio_pad_select_gpio(TEMPERATURE_CONTROL);
-    gpio_set_direction(TEMPERATURE_CONTROL, GPIO_MODE_OUTPUT);
-    while (1)
-    {
-        float current_temp = ds18b20_get_temp();
-        if (current_temp < temperatureLimit)
-        {
-            ESP_LOGE(DS18B20_TAG, "Resistência acionada");
-            gpio_set_level(TEMPERATURE_CONTROL, 0);
-        }
-        else
-        {
-            gpio_set_level(TEMPERATURE_CONTROL, 1);
-        }
+    state_t current;
+    state_get(&current);
 
-        ssd1306_clear_line(&dev, 2, false);
-        write_text();
+    tank_state_t results[TANK_COUNT];
+    for (int i = 0; i < TANK_COUNT; i++)
+    {
+        results[i] = current.tanks[i];
+        control_tank(&tanks[i], sample->timestamp, &sample->readings[i], &current, &results[i]);
+        eventlog_compare(i, &current.tanks[i], &results[i]);
+    }
 
-        ESP_LOGE(DS18B20_TAG, "Temperature: %0.2f C\n", current_temp);
-        waterTemperature = current_temp;
-        delay(READ_SENSORS_DELAY);
+    // Medidas do ciclo publicadas de uma vez; as configuracoes podem ter
+    // mudado desde o state_get e nao sao sobrescritas
+    state_t *state = state_write_begin();
+    state->timestamp = sample->timestamp;
+    for (int i = 0; i < TANK_COUNT; i++)
+    {
+        tank_state_t *tank = &state->tanks[i];
+        tank->waterDistance = results[i].waterDistance;
+        tank->waterPercent = results[i].waterPercent;
+        tank->waterLitres = results[i].waterLitres;
+        tank->capacityLitres = results[i].capacityLitres;
+        tank->waterTemperature = results[i].waterTemperature;
+        tank->levelRate = results[i].levelRate;
+        tank->etaSeconds = results[i].etaSeconds;
+        tank->pumpOn = results[i].pumpOn;
+        tank->heaterOn = results[i].heaterOn;
+        tank->alarms = results[i].alarms;
+        tank->faults = results[i].faults;
     }
+    state_write_end();
+
+    state_get(&current);
+    publish_state(&current);
+    for (int i = 0; i < TANK_COUNT; i++)
+        history_add(&current, i);
+    write_text();
+
+    // Proximo periodo conforme a variacao e a distancia aos limites; o
+    // reservatorio que pede a amostragem mais rapida define o ciclo
+    uint32_t period = UINT32_MAX;
+    for (int i = 0; i < TANK_COUNT; i++)
+    {
+        uint32_t wanted = rate_update(&tanks[i].rateCtl, sample->timestamp, &sample->readings[i], &current.tanks[i]);
+        if (wanted < period)
+            period = wanted;
+    }
+    if (period != samplePeriodMs)
+        ESP_LOGI(RATE_TAG, "Periodo de amostragem: %u ms", (unsigned)period);
+    samplePeriodMs = period;
+    sched_set_period(&acqTask, period);
+    sampleDueMs = now_ms() + period + acqTask.deadlineMs;
 }
 
 void IRAM_ATTR isrKeyDecrease(void *arg)
 {
+    if (!power_button_isr(DECREASE_BUTTON))
+        return;
+    TRACE_INSTANT(TRACE_BUTTON_ISR, DECREASE_BUTTON);
     TickType_t now_tick = xTaskGetTickCountFromISR();
-    if (((now_tick - last_tick_decrease) >= pdMS_TO_TICKS(DEBOUNCE_MS)) && !decrease_button)
+    if (((now_tick - last_tick_decrease) >= debounceTicks) && !decrease_button)
     {
         last_tick_decrease = now_tick;
         decrease_button = true;
@@ -186,8 +453,11 @@ void IRAM_ATTR isrKeyDecrease(void *arg)
 
 void IRAM_ATTR isrKeyIncrement(void *arg)
 {
+    if (!power_button_isr(INCREMENT_BUTTON))
+        return;
+    TRACE_INSTANT(TRACE_BUTTON_ISR, INCREMENT_BUTTON);
     TickType_t now_tick = xTaskGetTickCountFromISR();
-    if (((now_tick - last_tick_increment) >= pdMS_TO_TICKS(DEBOUNCE_MS)) && !increment_button)
+    if (((now_tick - last_tick_increment) >= debounceTicks) && !increment_button)
     {
         last_tick_increment = now_tick;
         increment_button = true;
@@ -196,8 +466,11 @@ void IRAM_ATTR isrKeyIncrement(void *arg)
 
 void IRAM_ATTR isrKeyChangeMode(void *arg)
 {
+    if (!power_button_isr(CHANGE_MODE_BUTTON))
+        return;
+    TRACE_INSTANT(TRACE_BUTTON_ISR, CHANGE_MODE_BUTTON);
     TickType_t now_tick = xTaskGetTickCountFromISR();
-    if (((now_tick - last_tick_change_mode) >= pdMS_TO_TICKS(DEBOUNCE_MS)) && !change_mode_button)
+    if (((now_tick - last_tick_change_mode) >= debounceTicks) && !change_mode_button)
     {
         last_tick_change_mode = now_tick;
         change_mode_button = true;
@@ -207,7 +480,7 @@ void IRAM_ATTR isrKeyChangeMode(void *arg)
 void setup_buttons()
 {
     gpio_config_t in_conf = {};
-    in_conf.intr_type = GPIO_INTR_NEGEDGE;
+    in_conf.intr_type = POWER_BUTTON_INTR;
     in_conf.mode = GPIO_MODE_INPUT;
     in_conf.pull_down_en = GPIO_PULLDOWN_DISABLE;
     in_conf.pull_up_en = GPIO_PULLUP_ENABLE;
@@ -221,6 +494,10 @@ void setup_buttons()
     in_conf.pin_bit_mask = (1 << CHANGE_MODE_BUTTON);
     gpio_config(&in_conf);
 
+    power_button_wakeup(DECREASE_BUTTON);
+    power_button_wakeup(INCREMENT_BUTTON);
+    power_button_wakeup(CHANGE_MODE_BUTTON);
+
     gpio_install_isr_service(0);
     gpio_isr_handler_add(DECREASE_BUTTON, isrKeyDecrease, NULL);
     gpio_isr_handler_add(INCREMENT_BUTTON, isrKeyIncrement, NULL);
@@ -229,97 +506,267 @@ void setup_buttons()
 
 void decrease_button_task(void *pvParams)
 {
-    for (;;)
+    if (decrease_button)
     {
-        if (decrease_button)
+        decrease_button = false;
+        state_t *state = state_write_begin();
+        tank_state_t *tank = &state->tanks[state->tank];
+        if (state->mode == TEMPERATURE_MODE)
         {
-            decrease_button = false;
-            if (currentMode == TEMPERATURE_MODE)
+            if (tank->temperatureLimit > STATE_TEMPERATURE_LIMIT_MIN)
             {
-                if (temperatureLimit > 10)
-                {
-                    temperatureLimit--;
-                    ssd1306_clear_line(&dev, 6, false);
-                }
+                tank->temperatureLimit--;
+                // Valores remotos podem estar fora do passo dos botoes
+                if (tank->temperatureLimit < STATE_TEMPERATURE_LIMIT_MIN)
+                    tank->temperatureLimit = STATE_TEMPERATURE_LIMIT_MIN;
             }
-            else
+        }
+        else if (state->mode == DISTANCE_MODE)
+        {
+            if (tank->storageCapacityLimit > STATE_CAPACITY_LIMIT_MIN)
             {
-                if (storageCapacityLimit > 10)
-                {
-                    storageCapacityLimit -= 5;
-                    ssd1306_clear_line(&dev, 5, false);
-                }
+                tank->storageCapacityLimit -= 5;
+                if (tank->storageCapacityLimit < STATE_CAPACITY_LIMIT_MIN)
+                    tank->storageCapacityLimit = STATE_CAPACITY_LIMIT_MIN;
             }
-            write_text();
-            ESP_LOGI(DECREASE_BUTTON_TAG, "Diminuir valor\n");
         }
-        delay(50);
+        state_t snapshot = *state;
+        state_write_end();
+        publish_state(&snapshot);
+        write_text();
+        ESP_LOGI(DECREASE_BUTTON_TAG, "Diminuir valor\n");
     }
 }
 
 void increment_button_task(void *pvParams)
 {
-    for (;;)
+    if (increment_button)
     {
-        if (increment_button)
+        increment_button = false;
+        state_t *state = state_write_begin();
+        tank_state_t *tank = &state->tanks[state->tank];
+        if (state->mode == TEMPERATURE_MODE)
         {
-            increment_button = false;
-            if (currentMode == TEMPERATURE_MODE)
+            if (tank->temperatureLimit < STATE_TEMPERATURE_LIMIT_MAX)
             {
-                if (temperatureLimit < 50)
-                {
-                    temperatureLimit++;
-                    ssd1306_clear_line(&dev, 6, false);
-                }
+                tank->temperatureLimit++;
+                // Valores remotos podem estar fora do passo dos botoes
+                if (tank->temperatureLimit > STATE_TEMPERATURE_LIMIT_MAX)
+                    tank->temperatureLimit = STATE_TEMPERATURE_LIMIT_MAX;
             }
-            else
+        }
+        else if (state->mode == DISTANCE_MODE)
+        {
+            if (tank->storageCapacityLimit < STATE_CAPACITY_LIMIT_MAX)
             {
-                if (storageCapacityLimit < 100)
-                {
-                    storageCapacityLimit += 5;
-                    ssd1306_clear_line(&dev, 5, false);
-                }
+                tank->storageCapacityLimit += 5;
+                if (tank->storageCapacityLimit > STATE_CAPACITY_LIMIT_MAX)
+                    tank->storageCapacityLimit = STATE_CAPACITY_LIMIT_MAX;
             }
-            write_text();
-            ESP_LOGI(INCREMENT_BUTTON_TAG, "Aumentar valor\n");
         }
-        delay(50);
+        state_t snapshot = *state;
+        state_write_end();
+        publish_state(&snapshot);
+        write_text();
+        ESP_LOGI(INCREMENT_BUTTON_TAG, "Aumentar valor\n");
     }
 }
 
 void change_mode_button_task(void *pvParams)
 {
-    for (;;)
+    if (change_mode_button)
     {
-        if (change_mode_button)
+        // Capacidade e temperatura de cada reservatorio em sequencia, e
+        // depois as telas de diagnostico e de eventos
+        state_t *state = state_write_begin();
+        int previousMode = state->mode;
+        if (previousMode == TEMPERATURE_MODE && state->tank + 1 < TANK_COUNT)
         {
-            if (currentMode == TEMPERATURE_MODE)
-            {
-                currentMode = DISTANCE_MODE;
-            }
-            else
-            {
-                currentMode = TEMPERATURE_MODE;
-            }
-            ssd1306_clear_line(&dev, 5, false);
-            ssd1306_clear_line(&dev, 6, false);
-            write_text();
-            change_mode_button = false;
-            ESP_LOGI(CHANGE_MODE_BUTTON_TAG, "Mudar modo: %d\n", currentMode);
+            state->tank++;
+            state->mode = DISTANCE_MODE;
+        }
+        else if (previousMode == TEMPERATURE_MODE)
+        {
+#if CONFIG_APP_DIAG_SCREEN
+            state->mode = DIAG_MODE;
+#elif CONFIG_APP_EVENT_SCREEN
+            state->mode = EVENT_MODE;
+#else
+            state->tank = 0;
+            state->mode = DISTANCE_MODE;
+#endif
+        }
+#if CONFIG_APP_EVENT_SCREEN
+        else if (previousMode == DIAG_MODE)
+        {
+            state->mode = EVENT_MODE;
+        }
+#endif
+        else if (previousMode == DIAG_MODE || previousMode == EVENT_MODE)
+        {
+            state->tank = 0;
+            state->mode = DISTANCE_MODE;
+        }
+        else
+        {
+            state->mode = TEMPERATURE_MODE;
         }
-        delay(50);
+        int mode = state->mode;
+        int tank = state->tank;
+        state_write_end();
+
+        // A troca de tela acontece fora da escrita do estado
+#if CONFIG_APP_DIAG_SCREEN
+        if (mode == DIAG_MODE)
+        {
+            int count;
+            widget_t *widgets = diag_widgets(&count);
+            screen_show(&mainScreen, widgets, count);
+        }
+#endif
+#if CONFIG_APP_EVENT_SCREEN
+        if (mode == EVENT_MODE)
+            screen_show_feed(&mainScreen, eventlog_next);
+#endif
+        if (mode == DISTANCE_MODE && (previousMode == DIAG_MODE || previousMode == EVENT_MODE))
+            screen_show(&mainScreen, mainWidgets, sizeof(mainWidgets) / sizeof(mainWidgets[0]));
+        write_text();
+        change_mode_button = false;
+        ESP_LOGI(CHANGE_MODE_BUTTON_TAG, "Mudar modo: %d, reservatorio %d\n", mode, tank + 1);
+    }
+}
+
+// Os tres botoes sao atendidos pela mesma tarefa de interface
+void buttons_task(void *pvParams)
+{
+    if (!decrease_button && !increment_button && !change_mode_button)
+    {
+        power_idle_check();
+        return;
+    }
+    // Com o display apagado o aperto apenas acende a tela
+    if (power_user_activity())
+    {
+        decrease_button = false;
+        increment_button = false;
+        change_mode_button = false;
+        write_text();
+        return;
+    }
+    decrease_button_task(pvParams);
+    increment_button_task(pvParams);
+    change_mode_button_task(pvParams);
+}
+
+// Canais preenchidos a partir de tankConfigs em app_main
+static acq_config_t acqConfig = {
+    .ds18b20 = PIN_DS18B20,
+    .onSample = on_sample,
+};
+
+// Aquisicao no core CONFIG_APP_ACQ_CORE, interface no CONFIG_APP_UI_CORE
+static sched_task_t acqTask = {
+    .name = "acq_task",
+    .setup = acq_setup,
+    .job = acq_task,
+    .arg = &acqConfig,
+    .periodMs = READ_SENSORS_DELAY,
+    .deadlineMs = 1000,
+    .stackSize = 2048 + 512 * TANK_COUNT, // copias do estado em on_sample
+    .priority = CONFIG_APP_ACQ_PRIORITY,
+    .core = CONFIG_APP_ACQ_CORE,
+};
+
+// No core da interface: continua rodando se a aquisicao travar o dela
+static sched_task_t watchdogTask = {
+    .name = "watchdog_task",
+    .job = watchdog_task,
+    .periodMs = WATCHDOG_PERIOD_MS,
+    .stackSize = 2048 + 512 * TANK_COUNT,
+    .priority = CONFIG_APP_UI_PRIORITY,
+    .core = CONFIG_APP_UI_CORE,
+};
+
+static sched_task_t buttonsTask = {
+    .name = "buttons_task",
+    .job = buttons_task,
+    .periodMs = BUTTON_POLL_MS,
+    .stackSize = 2048,
+    .priority = CONFIG_APP_UI_PRIORITY,
+    .core = CONFIG_APP_UI_CORE,
+};
+
+// Reservatorios e estado inicial a partir de tankConfigs
+static void setup_tanks(void)
+{
+    state_t initialState = {
+        .mode = DISTANCE_MODE,
+        .sampleMinMs = READ_SENSORS_DELAY,
+        .sampleMaxMs = CONFIG_APP_RATE_MAX_MS,
+        .debounceMs = DEBOUNCE_MS,
+        .levelRateNoise = LEVEL_RATE_NOISE,
+        .levelMeasureNoise = LEVEL_MEASURE_NOISE,
+    };
+    for (int i = 0; i < TANK_COUNT; i++)
+    {
+        const tank_config_t *config = &tankConfigs[i];
+        tank_state_t *tank = &initialState.tanks[i];
+        tank->temperatureLimit = config->temperatureLimit;
+        tank->storageCapacityLimit = config->capacityLimit;
+        tank->tankHeightCm = config->geometry.heightCm;
+        tank->shape = config->geometry.shape;
+        tank->diameterCm = config->geometry.diameterCm;
+        tank->lengthCm = config->geometry.lengthCm;
+        tank->coneHeightCm = config->geometry.coneHeightCm;
+        tank->etaSeconds = -1;
+
+        tanks[i].index = i;
+        tanks[i].config = config;
+        tanks[i].built.shape = GEOMETRY_SHAPES;
+        rate_init(&tanks[i].rateCtl, READ_SENSORS_DELAY, CONFIG_APP_RATE_MAX_MS,
+                  config->pump != GPIO_NUM_NC || config->heater != GPIO_NUM_NC);
+        level_init(&tanks[i].levelEst, LEVEL_RATE_NOISE, LEVEL_MEASURE_NOISE);
+        anomaly_init(&tanks[i].anomalyDet);
+        health_init(&tanks[i].levelHealth, config->name, "nivel", esp_timer_get_time());
+        health_init(&tanks[i].temperatureHealth, config->name, "temperatura", esp_timer_get_time());
+        acqConfig.channels[i] = config->sensors;
+        acq_set_range(i, config->geometry.heightCm);
+        tanks[i].fineTemperature = true;
+        acq_set_precision(i, config->heater != GPIO_NUM_NC);
     }
+    state_init(&initialState);
 }
 
 void app_main()
 {
-    uint32_t usStackDepth = 1024;
+    trace_init();
+    setup_tanks();
     setup_display_text(&dev);
+    power_init(&dev);
+    screen_init(&mainScreen, &dev, mainWidgets, sizeof(mainWidgets) / sizeof(mainWidgets[0]));
+    mainScreen.refresh = refresh_ui_state;
+    write_text();
     setup_buttons();
 
-    xTaskCreatePinnedToCore(&hcsr04_task, "hcsr04_task", usStackDepth * 2, NULL, 5, NULL, 0);
-    xTaskCreatePinnedToCore(&temperature_task, "temperature_task", usStackDepth * 2, NULL, 5, NULL, 0);
-    xTaskCreatePinnedToCore(&decrease_button_task, "decrease_button_task", usStackDepth * 2, NULL, 1, NULL, 0);
-    xTaskCreatePinnedToCore(&increment_button_task, "increment_button_task", usStackDepth * 2, NULL, 1, NULL, 0);
-    xTaskCreatePinnedToCore(&change_mode_button_task, "change_mode_button_task", usStackDepth * 2, NULL, 1, NULL, 0);
+    control_setup();
+    sampleDueMs = now_ms() + READ_SENSORS_DELAY + acqTask.deadlineMs;
+    sched_start(&acqTask);
+    sched_start(&buttonsTask);
+    sched_start(&watchdogTask);
+    diag_start();
+#if CONFIG_APP_MODBUS
+    modbus_uart_start(write_text);
+#endif
+#if CONFIG_APP_TELEMETRY
+    telemetry_start(on_remote_change);
+#endif
+#if CONFIG_APP_HTTP
+    http_start();
+#endif
+#if CONFIG_APP_BINLOG
+    binlog_start();
+#endif
+#if CONFIG_APP_CONSOLE
+    console_start(on_remote_change);
+#endif
 }
@@ -0,0 +1,144 @@
+#include "modbus.h"
+
+#define MODBUS_READ_HOLDING 0x03
+#define MODBUS_READ_INPUT 0x04
+#define MODBUS_WRITE_SINGLE 0x06
+#define MODBUS_WRITE_MULTIPLE 0x10
+#define MODBUS_READ_MAX 125
+#define MODBUS_WRITE_MAX 123
+
+uint16_t modbus_crc16(const uint8_t *data, size_t len)
+{
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++)
+    {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+    }
+    return crc;
+}
+
+static uint16_t get_u16(const uint8_t *data)
+{
+    return (uint16_t)(data[0] << 8 | data[1]);
+}
+
+static size_t put_u16(uint8_t *data, uint16_t value)
+{
+    data[0] = value >> 8;
+    data[1] = value & 0xFF;
+    return 2;
+}
+
+// O CRC vai em ordem little-endian, ao contrario dos registradores
+static size_t finish(uint8_t *resp, size_t len)
+{
+    uint16_t crc = modbus_crc16(resp, len);
+    resp[len++] = crc & 0xFF;
+    resp[len++] = crc >> 8;
+    return len;
+}
+
+static size_t exception(uint8_t *resp, uint8_t function, uint8_t code)
+{
+    resp[1] = function | 0x80;
+    resp[2] = code;
+    return finish(resp, 3);
+}
+
+static size_t read_registers(uint8_t *resp, uint8_t function, const uint16_t *regs, uint16_t total, const uint8_t *pdu, size_t pduLen)
+{
+    if (pduLen != 5)
+        return exception(resp, function, MODBUS_ILLEGAL_VALUE);
+    uint16_t start = get_u16(&pdu[1]);
+    uint16_t count = get_u16(&pdu[3]);
+    if (count == 0 || count > MODBUS_READ_MAX)
+        return exception(resp, function, MODBUS_ILLEGAL_VALUE);
+    if ((uint32_t)start + count > total)
+        return exception(resp, function, MODBUS_ILLEGAL_ADDRESS);
+
+    size_t len = 1;
+    resp[len++] = function;
+    resp[len++] = count * 2;
+    for (uint16_t i = 0; i < count; i++)
+        len += put_u16(&resp[len], regs[start + i]);
+    return finish(resp, len);
+}
+
+static size_t write_registers(modbus_slave_t *slave, uint8_t *resp, uint8_t function, const uint8_t *pdu, size_t pduLen)
+{
+    uint16_t start;
+    uint16_t count;
+    uint16_t values[MODBUS_WRITE_MAX];
+
+    if (function == MODBUS_WRITE_SINGLE)
+    {
+        if (pduLen != 5)
+            return exception(resp, function, MODBUS_ILLEGAL_VALUE);
+        start = get_u16(&pdu[1]);
+        count = 1;
+        values[0] = get_u16(&pdu[3]);
+    }
+    else
+    {
+        if (pduLen < 6)
+            return exception(resp, function, MODBUS_ILLEGAL_VALUE);
+        start = get_u16(&pdu[1]);
+        count = get_u16(&pdu[3]);
+        if (count == 0 || count > MODBUS_WRITE_MAX || pdu[5] != count * 2 || pduLen != 6 + (size_t)count * 2)
+            return exception(resp, function, MODBUS_ILLEGAL_VALUE);
+        for (uint16_t i = 0; i < count; i++)
+            values[i] = get_u16(&pdu[6 + i * 2]);
+    }
+    if ((uint32_t)start + count > slave->image->holdingCount)
+        return exception(resp, function, MODBUS_ILLEGAL_ADDRESS);
+    if (slave->write == NULL || !slave->write(start, values, count))
+        return exception(resp, function, MODBUS_ILLEGAL_VALUE);
+
+    // Ambas as respostas repetem endereco e valor/quantidade da requisicao
+    size_t len = 1;
+    resp[len++] = function;
+    len += put_u16(&resp[len], start);
+    len += put_u16(&resp[len], function == MODBUS_WRITE_SINGLE ? values[0] : count);
+    return finish(resp, len);
+}
+
+size_t modbus_handle(modbus_slave_t *slave, const uint8_t *frame, size_t len, uint8_t *resp)
+{
+    // Endereco, funcao e CRC no minimo
+    if (len < 4 || len > MODBUS_FRAME_MAX)
+        return 0;
+    if (modbus_crc16(frame, len - 2) != (uint16_t)(frame[len - 2] | frame[len - 1] << 8))
+        return 0;
+    uint8_t address = frame[0];
+    if (address != slave->address && address != 0)
+        return 0;
+
+    const uint8_t *pdu = &frame[1];
+    size_t pduLen = len - 3;
+    uint8_t function = pdu[0];
+    const modbus_image_t *image = slave->image;
+    size_t respLen;
+
+    resp[0] = slave->address;
+    switch (function)
+    {
+    case MODBUS_READ_HOLDING:
+        respLen = read_registers(resp, function, image->holding, image->holdingCount, pdu, pduLen);
+        break;
+    case MODBUS_READ_INPUT:
+        respLen = read_registers(resp, function, image->input, image->inputCount, pdu, pduLen);
+        break;
+    case MODBUS_WRITE_SINGLE:
+    case MODBUS_WRITE_MULTIPLE:
+        respLen = write_registers(slave, resp, function, pdu, pduLen);
+        break;
+    default:
+        respLen = exception(resp, function, MODBUS_ILLEGAL_FUNCTION);
+        break;
+    }
+
+    // Broadcast e executado mas nunca respondido
+    return address == 0 ? 0 : respLen;
+}
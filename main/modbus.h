@@ -0,0 +1,48 @@
+#ifndef MAIN_MODBUS_H_
+#define MAIN_MODBUS_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Nucleo do escravo Modbus RTU, sem dependencia do ESP-IDF: recebe um
+// quadro completo e monta a resposta a partir de uma imagem de
+// registradores ja convertida, sem formatar valores por requisicao.
+
+#define MODBUS_FRAME_MAX 256
+// Capacidade da imagem; a quantidade em uso fica em cada imagem
+#define MODBUS_INPUT_REGS 40
+#define MODBUS_HOLDING_REGS 8
+
+// Codigos de excecao
+#define MODBUS_ILLEGAL_FUNCTION 0x01
+#define MODBUS_ILLEGAL_ADDRESS 0x02
+#define MODBUS_ILLEGAL_VALUE 0x03
+
+typedef struct
+{
+    uint16_t input[MODBUS_INPUT_REGS];
+    uint16_t holding[MODBUS_HOLDING_REGS];
+    uint16_t inputCount; // registradores validos, o resto responde ILLEGAL_ADDRESS
+    uint16_t holdingCount;
+} modbus_image_t;
+
+// Valida e aplica uma escrita em holding registers ja dentro da faixa de
+// enderecos. Retorna false para responder ILLEGAL_VALUE sem aplicar nada.
+typedef bool (*modbus_write_t)(uint16_t reg, const uint16_t *values, uint16_t count);
+
+typedef struct
+{
+    uint8_t address;
+    const modbus_image_t *volatile image; // trocado inteiro pelo produtor
+    modbus_write_t write;
+} modbus_slave_t;
+
+uint16_t modbus_crc16(const uint8_t *data, size_t len);
+
+// Processa um quadro RTU (com CRC) e escreve a resposta em resp, que deve
+// ter MODBUS_FRAME_MAX bytes. Retorna o tamanho da resposta, 0 quando nao
+// ha resposta (CRC invalido, outro escravo ou broadcast).
+size_t modbus_handle(modbus_slave_t *slave, const uint8_t *frame, size_t len, uint8_t *resp);
+
+#endif /* MAIN_MODBUS_H_ */
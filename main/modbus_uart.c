@@ -0,0 +1,232 @@
+#include <sdkconfig.h>
+#if CONFIG_APP_MODBUS
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <driver/uart.h>
+#include <esp_log.h>
+#include <esp_pm.h>
+#include "modbus.h"
+#include "modbus_uart.h"
+#include "fixfmt.h"
+#include "diag.h"
+
+#define MODBUS_TAG "MODBUS"
+#define MODBUS_UART CONFIG_APP_MODBUS_UART
+#define MODBUS_RX_BUFFER 512
+#define MODBUS_QUEUE_LEN 16
+// Silencio de 3.5 caracteres fecha o quadro; o timeout da UART conta em
+// caracteres inteiros
+#define MODBUS_RX_TIMEOUT_CHARS 3
+
+_Static_assert(CONFIG_APP_TANK_COUNT * MODBUS_IR_STRIDE <= MODBUS_INPUT_REGS, "imagem Modbus pequena");
+_Static_assert(CONFIG_APP_TANK_COUNT * MODBUS_HR_STRIDE <= MODBUS_HOLDING_REGS, "imagem Modbus pequena");
+
+// Tres imagens: a publicada, a que a resposta em curso esta lendo e uma
+// livre. O produtor so preenche a livre e troca o ponteiro, entao o
+// leitor nunca ve uma imagem pela metade, mesmo com duas publicacoes
+// durante uma resposta, e so segura o lock para fixar a imagem
+static modbus_image_t images[3];
+static const modbus_image_t *reading;
+static portMUX_TYPE publishMux = portMUX_INITIALIZER_UNLOCKED;
+static QueueHandle_t uartQueue;
+static void (*writeCallback)(void);
+#if CONFIG_APP_POWER_SAVE
+// O mestre pode perguntar a qualquer momento e a UART nao recebe em sono
+// leve; o DFS continua valendo porque o baud vem do REF_TICK
+static esp_pm_lock_handle_t sleepLock;
+#endif
+
+static bool apply_holding(uint16_t reg, const uint16_t *values, uint16_t count);
+
+static modbus_slave_t slave = {
+    .address = CONFIG_APP_MODBUS_ADDRESS,
+    .image = &images[0],
+    .write = apply_holding,
+};
+
+static uint16_t saturate_u16(float value)
+{
+    if (value <= 0)
+        return 0;
+    return value >= 0xFFFF ? 0xFFFF : (uint16_t)(value + 0.5f);
+}
+
+void modbus_publish(const state_t *state)
+{
+    portENTER_CRITICAL(&publishMux);
+    modbus_image_t *image = &images[0];
+    while (image == slave.image || image == reading)
+        image++;
+
+    uint32_t seconds = (uint32_t)(state->timestamp / 1000000);
+    for (int i = 0; i < CONFIG_APP_TANK_COUNT; i++)
+    {
+        const tank_state_t *tank = &state->tanks[i];
+        uint16_t *input = &image->input[i * MODBUS_IR_STRIDE];
+        uint16_t *holding = &image->holding[i * MODBUS_HR_STRIDE];
+        input[MODBUS_IR_LEVEL] = (uint16_t)fix_from_float(tank->waterPercent, 2);
+        input[MODBUS_IR_DISTANCE] = (uint16_t)fix_from_float(tank->waterDistance, 2);
+        input[MODBUS_IR_TEMPERATURE] = (uint16_t)(int16_t)fix_from_float(tank->waterTemperature, 2);
+        input[MODBUS_IR_RATE] = (uint16_t)(int16_t)fix_from_float(tank->levelRate, 2);
+        input[MODBUS_IR_ETA] = tank->etaSeconds < 0 || tank->etaSeconds / 60 >= 0xFFFF ? 0xFFFF : tank->etaSeconds / 60;
+        input[MODBUS_IR_STATUS] = (tank->pumpOn ? 0x01 : 0) | (tank->heaterOn ? 0x02 : 0) | tank->faults << 2 | tank->alarms << 8;
+        input[MODBUS_IR_TIME_HI] = seconds >> 16;
+        input[MODBUS_IR_TIME_LO] = seconds & 0xFFFF;
+        input[MODBUS_IR_LITRES] = saturate_u16(tank->waterLitres);
+        input[MODBUS_IR_CAPACITY] = saturate_u16(tank->capacityLitres);
+        holding[MODBUS_HR_CAPACITY_LIMIT] = tank->storageCapacityLimit;
+        holding[MODBUS_HR_TEMPERATURE_LIMIT] = (uint16_t)fix_from_float(tank->temperatureLimit, 2);
+    }
+    image->inputCount = CONFIG_APP_TANK_COUNT * MODBUS_IR_STRIDE;
+    image->holdingCount = CONFIG_APP_TANK_COUNT * MODBUS_HR_STRIDE;
+
+    slave.image = image;
+    portEXIT_CRITICAL(&publishMux);
+}
+
+// Valida todos os valores antes de aplicar: uma escrita multipla e
+// aplicada inteira ou rejeitada
+static bool apply_holding(uint16_t reg, const uint16_t *values, uint16_t count)
+{
+    for (uint16_t i = 0; i < count; i++)
+    {
+        uint16_t value = values[i];
+        uint16_t field = (reg + i) % MODBUS_HR_STRIDE;
+        if (field == MODBUS_HR_CAPACITY_LIMIT &&
+            (value < STATE_CAPACITY_LIMIT_MIN || value > STATE_CAPACITY_LIMIT_MAX))
+            return false;
+        if (field == MODBUS_HR_TEMPERATURE_LIMIT &&
+            (value < STATE_TEMPERATURE_LIMIT_MIN * 100 || value > STATE_TEMPERATURE_LIMIT_MAX * 100))
+            return false;
+    }
+
+    state_t snapshot;
+    state_t *state = state_write_begin();
+    for (uint16_t i = 0; i < count; i++)
+    {
+        tank_state_t *tank = &state->tanks[(reg + i) / MODBUS_HR_STRIDE];
+        uint16_t field = (reg + i) % MODBUS_HR_STRIDE;
+        if (field == MODBUS_HR_CAPACITY_LIMIT)
+            tank->storageCapacityLimit = values[i];
+        else if (field == MODBUS_HR_TEMPERATURE_LIMIT)
+            tank->temperatureLimit = values[i] / 100.0f;
+    }
+    snapshot = *state;
+    state_write_end();
+
+    modbus_publish(&snapshot);
+    ESP_LOGI(MODBUS_TAG, "Escrita em %u registrador(es) a partir de %u", count, reg);
+    if (writeCallback != NULL)
+        writeCallback();
+    return true;
+}
+
+// Os bytes chegam em eventos UART_DATA; o evento com timeout_flag marca
+// o silencio de fim de quadro
+static void modbus_task(void *arg)
+{
+    uint8_t frame[MODBUS_FRAME_MAX];
+    uint8_t resp[MODBUS_FRAME_MAX];
+    size_t len = 0;
+    bool discard = false;
+    uart_event_t event;
+
+    for (;;)
+    {
+        if (xQueueReceive(uartQueue, &event, portMAX_DELAY) != pdTRUE)
+            continue;
+
+        switch (event.type)
+        {
+        case UART_DATA:
+        {
+            size_t room = sizeof(frame) - len;
+            size_t size = event.size;
+            if (size > room)
+            {
+                // Quadro maior que o permitido: o resto e lido e descartado
+                discard = true;
+                size = room;
+            }
+            len += uart_read_bytes(MODBUS_UART, &frame[len], size, 0);
+            if (event.size > size)
+            {
+                uint8_t drop[32];
+                for (size_t left = event.size - size; left > 0;)
+                {
+                    int n = uart_read_bytes(MODBUS_UART, drop, left < sizeof(drop) ? left : sizeof(drop), 0);
+                    if (n <= 0)
+                        break;
+                    left -= n;
+                }
+            }
+            if (event.timeout_flag)
+            {
+                if (!discard)
+                {
+                    // A resposta inteira sai da imagem fixada aqui
+                    modbus_slave_t view = slave;
+                    portENTER_CRITICAL(&publishMux);
+                    view.image = slave.image;
+                    reading = view.image;
+                    portEXIT_CRITICAL(&publishMux);
+                    size_t respLen = modbus_handle(&view, frame, len, resp);
+                    portENTER_CRITICAL(&publishMux);
+                    reading = NULL;
+                    portEXIT_CRITICAL(&publishMux);
+                    if (respLen > 0)
+                        uart_write_bytes(MODBUS_UART, resp, respLen);
+                }
+                len = 0;
+                discard = false;
+            }
+            break;
+        }
+        case UART_FIFO_OVF:
+        case UART_BUFFER_FULL:
+            uart_flush_input(MODBUS_UART);
+            xQueueReset(uartQueue);
+            len = 0;
+            discard = false;
+            break;
+        default:
+            // Erro de paridade ou de quadro: o quadro atual e invalido
+            discard = true;
+            break;
+        }
+    }
+}
+
+void modbus_uart_start(void (*onWrite)(void))
+{
+    writeCallback = onWrite;
+
+    state_t snapshot;
+    state_get(&snapshot);
+    modbus_publish(&snapshot);
+
+    uart_config_t config = {
+        .baud_rate = CONFIG_APP_MODBUS_BAUD,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        // REF_TICK fica em 1 MHz com o APB variando pelo DFS
+        .source_clk = UART_SCLK_REF_TICK,
+    };
+#if CONFIG_APP_POWER_SAVE
+    ESP_ERROR_CHECK(esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "modbus", &sleepLock));
+    ESP_ERROR_CHECK(esp_pm_lock_acquire(sleepLock));
+#endif
+    ESP_ERROR_CHECK(uart_driver_install(MODBUS_UART, MODBUS_RX_BUFFER, 0, MODBUS_QUEUE_LEN, &uartQueue, 0));
+    ESP_ERROR_CHECK(uart_param_config(MODBUS_UART, &config));
+    // No modo RS-485 half duplex o driver aciona o DE pelo pino RTS
+    ESP_ERROR_CHECK(uart_set_pin(MODBUS_UART, CONFIG_APP_MODBUS_TX_GPIO, CONFIG_APP_MODBUS_RX_GPIO, CONFIG_APP_MODBUS_DE_GPIO, UART_PIN_NO_CHANGE));
+    ESP_ERROR_CHECK(uart_set_mode(MODBUS_UART, UART_MODE_RS485_HALF_DUPLEX));
+    ESP_ERROR_CHECK(uart_set_rx_timeout(MODBUS_UART, MODBUS_RX_TIMEOUT_CHARS));
+
+    diag_task_create(modbus_task, "modbus_task", 3072, NULL, CONFIG_APP_MODBUS_PRIORITY, CONFIG_APP_UI_CORE);
+    ESP_LOGI(MODBUS_TAG, "Escravo %d em UART%d a %d baud", CONFIG_APP_MODBUS_ADDRESS, MODBUS_UART, CONFIG_APP_MODBUS_BAUD);
+}
+#endif
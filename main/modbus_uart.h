@@ -0,0 +1,48 @@
+#ifndef MAIN_MODBUS_UART_H_
+#define MAIN_MODBUS_UART_H_
+
+#include "state.h"
+
+// Mapa de registradores do escravo Modbus RTU. Cada reservatorio ocupa um
+// bloco: os enderecos abaixo somam n * MODBUS_IR_STRIDE nos input
+// registers e n * MODBUS_HR_STRIDE nos holding registers, com n a partir
+// de 0 ate CONFIG_APP_TANK_COUNT - 1.
+//
+// Input registers (funcao 04):
+//   0  nivel, % do volume x100
+//   1  distancia do sensor a agua, cm x100
+//   2  temperatura, C x100 (com sinal)
+//   3  vazao estimada, %/min x100 (com sinal, positiva enchendo)
+//   4  minutos ate encher ou esvaziar, 0xFFFF com nivel estavel
+//   5  bit 0 bomba, bit 1 resistencia, bits 2-6 falhas de sensor
+//      (HEALTH_*), bits 8-15 alarmes (ANOMALY_*)
+//   6  instante da amostra em s desde o boot, palavra alta
+//   7  instante da amostra em s desde o boot, palavra baixa
+//   8  volume, litros (satura em 65535)
+//   9  capacidade pelo perfil atual, litros (satura em 65535)
+//
+// Holding registers (funcoes 03, 06 e 16):
+//   0  limite de capacidade, %
+//   1  limite de temperatura, C x100
+#define MODBUS_IR_LEVEL 0
+#define MODBUS_IR_DISTANCE 1
+#define MODBUS_IR_TEMPERATURE 2
+#define MODBUS_IR_RATE 3
+#define MODBUS_IR_ETA 4
+#define MODBUS_IR_STATUS 5
+#define MODBUS_IR_TIME_HI 6
+#define MODBUS_IR_TIME_LO 7
+#define MODBUS_IR_LITRES 8
+#define MODBUS_IR_CAPACITY 9
+#define MODBUS_HR_CAPACITY_LIMIT 0
+#define MODBUS_HR_TEMPERATURE_LIMIT 1
+#define MODBUS_IR_STRIDE 10
+#define MODBUS_HR_STRIDE 2
+
+// onWrite e chamado na tarefa Modbus depois de uma escrita aceita
+void modbus_uart_start(void (*onWrite)(void));
+
+// Reconstroi a imagem de registradores; chamar apos cada mudanca no estado
+void modbus_publish(const state_t *state);
+
+#endif /* MAIN_MODBUS_UART_H_ */
@@ -0,0 +1,128 @@
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_log.h>
+#include <esp_pm.h>
+#include <esp_sleep.h>
+#include "power.h"
+
+#define POWER_TAG "POWER"
+#define POWER_FULL_CONTRAST 0xff
+
+typedef enum
+{
+    DISPLAY_ON,
+    DISPLAY_DIM,
+    DISPLAY_OFF,
+} display_power_t;
+
+static SSD1306_t *display;
+static volatile display_power_t displayPower = DISPLAY_ON;
+static TickType_t lastActivity;
+
+#if CONFIG_APP_POWER_SAVE
+static esp_pm_lock_handle_t cpuLock;
+static esp_pm_lock_handle_t sleepLock;
+#endif
+
+void power_init(SSD1306_t *dev)
+{
+    display = dev;
+    lastActivity = xTaskGetTickCount();
+
+#if CONFIG_APP_POWER_SAVE
+    // O tickless idle entra em light sleep sempre que nenhuma tarefa
+    // estiver pronta ate o proximo evento agendado
+    esp_pm_config_esp32_t config = {
+        .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .min_freq_mhz = CONFIG_XTAL_FREQ,
+        .light_sleep_enable = true,
+    };
+    ESP_ERROR_CHECK(esp_pm_configure(&config));
+    ESP_ERROR_CHECK(esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "busy_cpu", &cpuLock));
+    ESP_ERROR_CHECK(esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "busy_sleep", &sleepLock));
+    ESP_ERROR_CHECK(esp_sleep_enable_gpio_wakeup());
+    ESP_LOGI(POWER_TAG, "Light sleep automatico, CPU %d-%d MHz", config.min_freq_mhz, config.max_freq_mhz);
+#endif
+}
+
+void power_busy_begin(void)
+{
+#if CONFIG_APP_POWER_SAVE
+    esp_pm_lock_acquire(sleepLock);
+    esp_pm_lock_acquire(cpuLock);
+#endif
+}
+
+void power_busy_end(void)
+{
+#if CONFIG_APP_POWER_SAVE
+    esp_pm_lock_release(cpuLock);
+    esp_pm_lock_release(sleepLock);
+#endif
+}
+
+void power_button_wakeup(gpio_num_t pin)
+{
+#if CONFIG_APP_POWER_SAVE
+    gpio_wakeup_enable(pin, GPIO_INTR_LOW_LEVEL);
+#endif
+}
+
+// Chamado no inicio da ISR do botao; retorna true no aperto.
+// Em nivel, a interrupcao se repetiria enquanto o botao estiver
+// pressionado: o nivel esperado alterna entre baixo (aperto) e alto
+// (soltura), gerando uma interrupcao para cada transicao.
+bool IRAM_ATTR power_button_isr(gpio_num_t pin)
+{
+#if CONFIG_APP_POWER_SAVE
+    if (gpio_get_level(pin) == 0)
+    {
+        gpio_wakeup_enable(pin, GPIO_INTR_HIGH_LEVEL);
+        return true;
+    }
+    gpio_wakeup_enable(pin, GPIO_INTR_LOW_LEVEL);
+    return false;
+#else
+    return true;
+#endif
+}
+
+// Registra um aperto. Retorna true se o display estava apagado: nesse
+// caso o aperto so acende a tela e nao deve alterar configuracoes.
+bool power_user_activity(void)
+{
+    lastActivity = xTaskGetTickCount();
+    display_power_t previous = displayPower;
+    if (previous == DISPLAY_OFF)
+        ssd1306_display_power(display, true);
+    if (previous != DISPLAY_ON)
+    {
+        ssd1306_contrast(display, POWER_FULL_CONTRAST);
+        displayPower = DISPLAY_ON;
+    }
+    return previous == DISPLAY_OFF;
+}
+
+// Reduz o contraste e depois apaga o display apos periodos sem apertos.
+// Um tempo igual a zero desabilita a etapa correspondente.
+void power_idle_check(void)
+{
+    TickType_t idle = xTaskGetTickCount() - lastActivity;
+    if (CONFIG_APP_DISPLAY_OFF_S > 0 && displayPower != DISPLAY_OFF && idle >= pdMS_TO_TICKS(CONFIG_APP_DISPLAY_OFF_S * 1000))
+    {
+        ssd1306_display_power(display, false);
+        displayPower = DISPLAY_OFF;
+        ESP_LOGI(POWER_TAG, "Display apagado");
+    }
+    else if (CONFIG_APP_DISPLAY_DIM_S > 0 && displayPower == DISPLAY_ON && idle >= pdMS_TO_TICKS(CONFIG_APP_DISPLAY_DIM_S * 1000))
+    {
+        ssd1306_contrast(display, CONFIG_APP_DISPLAY_DIM_CONTRAST);
+        displayPower = DISPLAY_DIM;
+    }
+}
+
+// Com o display apagado as atualizacoes de tela sao adiadas ate acordar
+bool power_display_awake(void)
+{
+    return displayPower != DISPLAY_OFF;
+}
@@ -0,0 +1,31 @@
+#ifndef MAIN_POWER_H_
+#define MAIN_POWER_H_
+
+#include <stdbool.h>
+#include <driver/gpio.h>
+#include "ssd1306.h"
+
+// Com light sleep o GPIO so desperta o chip por nivel, nao por borda
+#if CONFIG_APP_POWER_SAVE
+#define POWER_BUTTON_INTR GPIO_INTR_LOW_LEVEL
+#else
+#define POWER_BUTTON_INTR GPIO_INTR_NEGEDGE
+#endif
+
+void power_init(SSD1306_t *dev);
+
+// Trechos com temporizacao por software (pulso do HC-SR04, slots 1-Wire)
+// rodam com a CPU na frequencia maxima e sem light sleep
+void power_busy_begin(void);
+void power_busy_end(void);
+
+// Botoes ativos em nivel baixo que tambem acordam o chip
+void power_button_wakeup(gpio_num_t pin);
+bool power_button_isr(gpio_num_t pin);
+
+// Apagamento do display por inatividade, chamados pela tarefa de interface
+bool power_user_activity(void);
+void power_idle_check(void);
+bool power_display_awake(void);
+
+#endif /* MAIN_POWER_H_ */
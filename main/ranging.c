@@ -0,0 +1,298 @@
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+#include <esp_log.h>
+#include "ranging.h"
+#include "hcsr04.h"
+#include "trace.h"
+
+#define RANGING_TAG "RANGING"
+// Folga da janela sobre o ida e volta ate o fundo: a velocidade do som
+// varia ~0.17 %/C com a temperatura do ar
+#define RANGING_WINDOW_MARGIN 1.1f
+// Sensor ainda com o pino alto de um eco perdido ignora o trigger:
+// consulta o pino neste intervalo e desiste do pulso depois do limite
+#define RANGING_BUSY_POLL_US 2000
+#define RANGING_BUSY_MAX_US 100000
+
+#define RANGING_RANGERS (ACQ_CHANNELS * ACQ_RANGERS)
+#define RANGING_ECHOES (ACQ_RANGERS * CONFIG_APP_ACQ_PINGS)
+
+// Reservatorios isolados acusticamente pingam ao mesmo tempo; senao todos
+// os sensores dividem uma unica sequencia
+#if CONFIG_APP_ACQ_PARALLEL_TANKS
+#define RANGING_LANES ACQ_CHANNELS
+#define RANGING_LANE_PINGS RANGING_ECHOES
+#else
+#define RANGING_LANES 1
+#define RANGING_LANE_PINGS (ACQ_CHANNELS * RANGING_ECHOES)
+#endif
+
+typedef struct
+{
+    gpio_num_t trigger;
+    gpio_num_t echo;
+    int channel;
+    // Bordas do pino echo, gravadas pela interrupcao (0 = ainda nao veio).
+    // A interrupcao roda no core dos botoes e a leitura no da aquisicao:
+    // acesso de 64 bits nao e atomico, entao o par so e lido ou gravado
+    // com edgeMux
+    int64_t rise;
+    int64_t fall;
+} ranger_t;
+
+typedef enum
+{
+    LANE_GUARD, // esperando o eco anterior se dissipar
+    LANE_ECHO,  // pulso disparado, esperando a descida do eco
+    LANE_DONE,
+} lane_state_t;
+
+// Sequencia de pulsos que nunca se sobrepoem no tempo
+typedef struct
+{
+    uint8_t order[RANGING_LANE_PINGS]; // indices em rangers
+    int count;
+    int next;
+    lane_state_t state;
+    ranger_t *current;
+    int64_t triggeredAt;
+    int64_t busySince; // 0: proximo sensor livre
+    int64_t deadline;  // proximo instante em que a sequencia tem o que fazer
+} lane_t;
+
+static ranger_t rangers[RANGING_RANGERS];
+static int rangerCount;
+static lane_t lanes[RANGING_LANES];
+static int64_t windowUs[ACQ_CHANNELS];
+static int64_t echoes[ACQ_CHANNELS][RANGING_ECHOES];
+static int echoCount[ACQ_CHANNELS];
+static int answered[ACQ_CHANNELS]; // pulsos com eco, dentro da janela ou nao
+static portMUX_TYPE edgeMux = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t volatile waiter;
+static esp_timer_handle_t wakeTimer;
+
+static void IRAM_ATTR echo_isr(void *arg)
+{
+    ranger_t *ranger = arg;
+    int64_t now = esp_timer_get_time();
+    bool high = gpio_get_level(ranger->echo);
+    portENTER_CRITICAL_ISR(&edgeMux);
+    if (high)
+    {
+        // Com o pulso aberto, uma borda lida em nivel alto e um pico para
+        // baixo ja terminado (errata 3.11 do ESP32 em GPIO36/39); tomar
+        // como subida encurtaria a medida
+        if (ranger->rise == 0 || ranger->fall > ranger->rise)
+            ranger->rise = now;
+    }
+    else
+    {
+        ranger->fall = now;
+    }
+    portEXIT_CRITICAL_ISR(&edgeMux);
+    if (high)
+        return;
+    TaskHandle_t task = waiter;
+    if (task != NULL)
+    {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(task, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+}
+
+// O tick de 10 ms e longo demais para as janelas de eco
+static void wake_waiter(void *arg)
+{
+    TaskHandle_t task = waiter;
+    if (task != NULL)
+        xTaskNotifyGive(task);
+}
+
+void ranging_setup(const acq_channel_t *channels)
+{
+    // Normalmente ja instalado pelos botoes (ESP_ERR_INVALID_STATE)
+    gpio_install_isr_service(0);
+    for (int ch = 0; ch < ACQ_CHANNELS; ch++)
+    {
+        const acq_channel_t *channel = &channels[ch];
+        if (channel->rangerCount <= 0)
+            ESP_LOGW(RANGING_TAG, "Canal %d sem sensor ultrassonico", ch);
+        for (int r = 0; r < channel->rangerCount && r < ACQ_RANGERS; r++)
+        {
+            ranger_t *ranger = &rangers[rangerCount++];
+            ranger->trigger = channel->rangers[r].trigger;
+            ranger->echo = channel->rangers[r].echo;
+            ranger->channel = ch;
+            hcsr04_init(ranger->trigger, ranger->echo);
+            gpio_set_intr_type(ranger->echo, GPIO_INTR_ANYEDGE);
+            gpio_isr_handler_add(ranger->echo, echo_isr, ranger);
+        }
+    }
+
+    const esp_timer_create_args_t args = {
+        .callback = wake_waiter,
+        .name = "ranging",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&args, &wakeTimer));
+}
+
+// Cada rodada passa por todos os sensores antes de repetir um, o que da a
+// um HC-SR04 com eco perdido o tempo de baixar o pino
+static void plan(int pings)
+{
+    for (int l = 0; l < RANGING_LANES; l++)
+    {
+        lanes[l].count = 0;
+        lanes[l].next = 0;
+        lanes[l].state = LANE_GUARD;
+        lanes[l].busySince = 0;
+        lanes[l].deadline = 0;
+    }
+    for (int p = 0; p < pings; p++)
+    {
+        for (int i = 0; i < rangerCount; i++)
+        {
+            lane_t *lane = &lanes[RANGING_LANES == 1 ? 0 : rangers[i].channel];
+            lane->order[lane->count++] = i;
+        }
+    }
+}
+
+// Avanca a sequencia ate onde o tempo permite e atualiza lane->deadline
+static void lane_step(lane_t *lane, int64_t now)
+{
+    if (lane->state == LANE_ECHO)
+    {
+        ranger_t *ranger = lane->current;
+        int ch = ranger->channel;
+        portENTER_CRITICAL(&edgeMux);
+        int64_t rise = ranger->rise;
+        int64_t fall = ranger->fall;
+        portEXIT_CRITICAL(&edgeMux);
+        bool complete = rise != 0 && fall > rise;
+        // Sem subida o sensor nao respondeu; sem descida dentro da janela o
+        // eco nao veio da agua nem do fundo deste reservatorio
+        int64_t timeout = rise != 0 ? rise + windowUs[ch] : lane->triggeredAt + HCSR04_SETUP_US;
+        if (!complete && now < timeout)
+        {
+            lane->deadline = timeout;
+            return;
+        }
+        int64_t us = complete ? fall - rise : 0;
+        if (complete && us >= HCSR04_CM_TO_US(HCSR04_MIN_CM) && us <= windowUs[ch])
+            echoes[ch][echoCount[ch]++] = us;
+        if (rise != 0)
+            answered[ch]++;
+        TRACE_END(TRACE_HCSR04_MEASURE, us);
+        // Reflexoes multiplas entre a agua e o sensor ainda chegam depois do
+        // primeiro eco e seriam lidas pelo proximo pulso
+        lane->state = LANE_GUARD;
+        lane->deadline = (complete ? fall : now) + CONFIG_APP_ACQ_ECHO_DECAY * windowUs[ch];
+    }
+    if (lane->state != LANE_GUARD || now < lane->deadline)
+        return;
+
+    if (lane->next == lane->count)
+    {
+        lane->state = LANE_DONE;
+        return;
+    }
+    ranger_t *ranger = &rangers[lane->order[lane->next]];
+    if (gpio_get_level(ranger->echo))
+    {
+        if (lane->busySince == 0)
+            lane->busySince = now;
+        if (now - lane->busySince < RANGING_BUSY_MAX_US)
+        {
+            lane->deadline = now + RANGING_BUSY_POLL_US;
+            return;
+        }
+        ESP_LOGW(RANGING_TAG, "Eco preso no pino %d", ranger->echo);
+        lane->next++;
+        lane->busySince = 0;
+        lane->deadline = now;
+        return;
+    }
+
+    lane->busySince = 0;
+    lane->next++;
+    lane->current = ranger;
+    portENTER_CRITICAL(&edgeMux);
+    ranger->rise = 0;
+    ranger->fall = 0;
+    portEXIT_CRITICAL(&edgeMux);
+    TRACE_BEGIN(TRACE_HCSR04_MEASURE, ranger->trigger);
+    lane->triggeredAt = esp_timer_get_time();
+    hcsr04_trigger(ranger->trigger);
+    lane->state = LANE_ECHO;
+    lane->deadline = lane->triggeredAt + HCSR04_SETUP_US;
+}
+
+static int64_t median_us(int64_t *values, int count)
+{
+    for (int i = 1; i < count; i++)
+    {
+        int64_t value = values[i];
+        int j = i - 1;
+        for (; j >= 0 && values[j] > value; j--)
+            values[j + 1] = values[j];
+        values[j + 1] = value;
+    }
+    return values[count / 2];
+}
+
+void ranging_run(int pings, const float *maxRangeCm, acq_reading_t *readings)
+{
+    if (pings > CONFIG_APP_ACQ_PINGS)
+        pings = CONFIG_APP_ACQ_PINGS;
+    for (int ch = 0; ch < ACQ_CHANNELS; ch++)
+    {
+        float cm = maxRangeCm[ch] > 0 && maxRangeCm[ch] < HCSR04_MAX_CM ? maxRangeCm[ch] : HCSR04_MAX_CM;
+        windowUs[ch] = (int64_t)HCSR04_CM_TO_US(cm * RANGING_WINDOW_MARGIN);
+        echoCount[ch] = 0;
+        answered[ch] = 0;
+    }
+    plan(pings);
+
+    waiter = xTaskGetCurrentTaskHandle();
+    // Descarta avisos de ecos que chegaram depois da rodada anterior
+    ulTaskNotifyTake(pdTRUE, 0);
+    for (;;)
+    {
+        int64_t now = esp_timer_get_time();
+        int64_t next = INT64_MAX;
+        for (int l = 0; l < RANGING_LANES; l++)
+        {
+            lane_step(&lanes[l], now);
+            if (lanes[l].state != LANE_DONE && lanes[l].deadline < next)
+                next = lanes[l].deadline;
+        }
+        if (next == INT64_MAX)
+            break;
+
+        int64_t wait = next - esp_timer_get_time();
+        if (wait <= 0)
+            continue;
+        // Acorda pela descida de um eco ou pelo temporizador; o timeout em
+        // ticks so cobre uma falha do temporizador
+        esp_timer_start_once(wakeTimer, wait);
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait / 1000) + 2);
+        esp_timer_stop(wakeTimer);
+    }
+    waiter = NULL;
+
+    for (int ch = 0; ch < ACQ_CHANNELS; ch++)
+    {
+        readings[ch].distanceValid = echoCount[ch] > 0;
+        if (readings[ch].distanceValid)
+            readings[ch].distanceCm = HCSR04_US_TO_CM(median_us(echoes[ch], echoCount[ch]));
+        // Sensor que responde com ecos fora da janela esta ligado, mas mede
+        // algo que nao e a agua deste reservatorio
+        if (readings[ch].distanceValid)
+            readings[ch].distanceFault = ACQ_OK;
+        else
+            readings[ch].distanceFault = answered[ch] > 0 ? ACQ_IMPLAUSIBLE : ACQ_TIMEOUT;
+    }
+}
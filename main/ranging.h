@@ -0,0 +1,19 @@
+#ifndef MAIN_RANGING_H_
+#define MAIN_RANGING_H_
+
+#include "acq.h"
+
+// Escalonador dos HC-SR04: o eco e medido por interrupcao e os pulsos dos
+// sensores que compartilham o meio acustico saem em turnos. Cada pulso so
+// espera o ida e volta maximo do seu reservatorio mais o tempo de o eco se
+// dissipar, em vez de um intervalo fixo.
+
+// Configura os pinos e a interrupcao de eco de todos os canais
+void ranging_setup(const acq_channel_t *channels);
+
+// Faz `pings` medidas com cada sensor e preenche distanceCm/distanceValid
+// de cada canal com a mediana dos ecos validos, e distanceFault sem eles. maxRangeCm[canal] limita a
+// janela do eco (<= 0: alcance do HC-SR04). Bloqueia a tarefa chamadora.
+void ranging_run(int pings, const float *maxRangeCm, acq_reading_t *readings);
+
+#endif /* MAIN_RANGING_H_ */
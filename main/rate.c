@@ -0,0 +1,64 @@
+#include <math.h>
+#include "rate.h"
+
+// Degrau da leitura do DS18B20 na resolucao grossa, a maior em uso
+#define RATE_TEMP_STEP (0.5f / (1 << (CONFIG_APP_ACQ_COARSE_BITS - 9)))
+
+void rate_init(rate_ctl_t *ctl, uint32_t minMs, uint32_t maxMs, bool supervised)
+{
+    ctl->supervised = supervised;
+    ctl->minMs = minMs;
+    ctl->maxMs = maxMs;
+    ctl->periodMs = minMs;
+    ctl->primed = false;
+    ctl->haveReference = false;
+}
+
+// Chamado apos publicar a amostra: tank ja contem as medidas do ciclo
+uint32_t rate_update(rate_ctl_t *ctl, int64_t timestamp, const acq_reading_t *reading, const tank_state_t *tank)
+{
+    // Sensor falhando: amostrar rapido para o prazo da falha valer
+    bool urgent = tank->faults != 0;
+
+    if (reading->distanceValid &&
+        fabsf(tank->waterPercent - state_capacity_limit(tank)) < CONFIG_APP_RATE_LEVEL_MARGIN)
+        urgent = true;
+    if (reading->temperatureValid &&
+        fabsf(tank->waterTemperature - tank->temperatureLimit) < CONFIG_APP_RATE_TEMP_MARGIN)
+        urgent = true;
+
+    // Vazao do filtro de nivel: a diferenca entre duas medidas cruas e
+    // dominada pelo ruido do ultrassom, maior que o limiar
+    if (reading->distanceValid && fabsf(tank->levelRate) > CONFIG_APP_RATE_LEVEL_SLOPE)
+        urgent = true;
+
+    // A temperatura anda em degraus de um LSB e oscila entre dois vizinhos
+    // mesmo parada. A inclinacao so e medida depois de uma variacao de mais
+    // de um degrau desde a referencia, que ate la nao se move; uma deriva
+    // lenta acumula sobre uma base longa e fica abaixo do limiar.
+    if (reading->temperatureValid)
+    {
+        float change = fabsf(tank->waterTemperature - ctl->lastTemperature);
+        float minutes = (timestamp - ctl->lastTimestamp) / 60e6f;
+        if (!ctl->haveReference || change > RATE_TEMP_STEP)
+        {
+            if (ctl->haveReference && minutes > 0 && change / minutes * 100 > CONFIG_APP_RATE_TEMP_SLOPE)
+                urgent = true;
+            ctl->haveReference = true;
+            ctl->lastTimestamp = timestamp;
+            ctl->lastTemperature = tank->waterTemperature;
+        }
+    }
+
+    if (!ctl->primed)
+        urgent = true;
+    ctl->primed = true;
+
+    uint32_t period = urgent ? ctl->minMs : ctl->periodMs * 2;
+    if (period > ctl->maxMs)
+        period = ctl->maxMs;
+    if (ctl->supervised && period > CONFIG_APP_HEALTH_TIMEOUT_MS)
+        period = CONFIG_APP_HEALTH_TIMEOUT_MS;
+    ctl->periodMs = period;
+    return period;
+}
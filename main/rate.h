@@ -0,0 +1,30 @@
+#ifndef MAIN_RATE_H_
+#define MAIN_RATE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "acq.h"
+#include "state.h"
+
+// Periodo de amostragem adaptativo: cai para o minimo quando o nivel ou a
+// temperatura variam rapido ou estao perto de um limite, e dobra a cada
+// amostra estavel ate o maximo. Com atuador em controle automatico o
+// periodo nao passa de CONFIG_APP_HEALTH_TIMEOUT_MS, que assim limita o
+// atraso ate o estado seguro.
+typedef struct
+{
+    uint32_t minMs;
+    uint32_t maxMs;
+    uint32_t periodMs;
+    // Referencia da inclinacao da temperatura
+    int64_t lastTimestamp;
+    float lastTemperature;
+    bool haveReference;
+    bool supervised; // atuador em controle automatico: periodo ate o prazo de falha
+    bool primed;
+} rate_ctl_t;
+
+void rate_init(rate_ctl_t *ctl, uint32_t minMs, uint32_t maxMs, bool supervised);
+uint32_t rate_update(rate_ctl_t *ctl, int64_t timestamp, const acq_reading_t *reading, const tank_state_t *tank);
+
+#endif /* MAIN_RATE_H_ */
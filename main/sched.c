@@ -0,0 +1,57 @@
+#include <esp_log.h>
+#include <esp_timer.h>
+#include "sched.h"
+#include "diag.h"
+
+#define SCHED_TAG "SCHED"
+
+static void sched_task(void *pvParams)
+{
+    sched_task_t *task = pvParams;
+    if (task->setup != NULL)
+        task->setup(task->arg);
+
+    TickType_t lastWake = xTaskGetTickCount();
+    for (;;)
+    {
+        int64_t start = esp_timer_get_time();
+        task->job(task->arg);
+        uint32_t elapsedUs = esp_timer_get_time() - start;
+
+        uint32_t periodMs = task->periodMs;
+        uint32_t deadlineMs = task->deadlineMs ? task->deadlineMs : periodMs;
+        task->runs++;
+        if (elapsedUs > task->worstUs)
+            task->worstUs = elapsedUs;
+        if (elapsedUs > deadlineMs * 1000)
+        {
+            task->overruns++;
+            ESP_LOGW(SCHED_TAG, "%s: %u us, prazo de %u ms estourado (%u vezes)", task->name,
+                     (unsigned)elapsedUs, (unsigned)deadlineMs, (unsigned)task->overruns);
+        }
+
+        // Se o job passou do periodo, recomeca a contagem em vez de disparar
+        // varias execucoes seguidas para compensar
+        TickType_t now = xTaskGetTickCount();
+        if (now - lastWake >= pdMS_TO_TICKS(periodMs))
+            lastWake = now;
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(periodMs));
+    }
+}
+
+BaseType_t sched_start(sched_task_t *task)
+{
+    task->runs = 0;
+    task->overruns = 0;
+    task->worstUs = 0;
+    BaseType_t ret = diag_task_create(&sched_task, task->name, task->stackSize, task, task->priority, task->core);
+    if (ret == pdPASS)
+        ESP_LOGI(SCHED_TAG, "%s: %u ms, core %d, prioridade %u", task->name, (unsigned)task->periodMs, task->core, task->priority);
+    return ret;
+}
+
+// Vale a partir da proxima espera
+void sched_set_period(sched_task_t *task, uint32_t periodMs)
+{
+    task->periodMs = periodMs;
+}
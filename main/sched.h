@@ -0,0 +1,32 @@
+#ifndef MAIN_SCHED_H_
+#define MAIN_SCHED_H_
+
+#include <stdint.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+typedef void (*sched_job_t)(void *arg);
+
+// Tarefa periodica de taxa fixa: o periodo conta a partir do inicio de cada
+// execucao (vTaskDelayUntil), entao o tempo de medicao nao acumula atraso.
+typedef struct
+{
+    const char *name;
+    sched_job_t setup; // executado uma vez na propria tarefa (pode ser NULL)
+    sched_job_t job;
+    void *arg;
+    uint32_t periodMs;
+    uint32_t deadlineMs; // tempo maximo de execucao do job, 0 = o periodo
+    uint32_t stackSize;
+    UBaseType_t priority;
+    BaseType_t core;
+    // Estatisticas
+    uint32_t runs;
+    uint32_t overruns;
+    uint32_t worstUs;
+} sched_task_t;
+
+BaseType_t sched_start(sched_task_t *task);
+void sched_set_period(sched_task_t *task, uint32_t periodMs);
+
+#endif /* MAIN_SCHED_H_ */
@@ -0,0 +1,157 @@
+#include <stdlib.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include "state.h"
+#include "geometry.h"
+
+static state_t current;
+// Par durante leituras estaveis, impar enquanto uma escrita esta em andamento
+static uint32_t sequence;
+static portMUX_TYPE writerMux = portMUX_INITIALIZER_UNLOCKED;
+
+void state_init(const state_t *initial)
+{
+    state_t *state = state_write_begin();
+    *state = *initial;
+    state_write_end();
+}
+
+void state_get(state_t *snapshot)
+{
+    uint32_t before;
+    uint32_t after;
+    do
+    {
+        before = __atomic_load_n(&sequence, __ATOMIC_ACQUIRE);
+        memcpy(snapshot, (const void *)&current, sizeof(state_t));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        after = __atomic_load_n(&sequence, __ATOMIC_RELAXED);
+    } while ((before & 1) || before != after);
+}
+
+state_t *state_write_begin(void)
+{
+    // A secao critica tambem impede que um leitor no mesmo core
+    // interrompa a escrita e fique esperando por ela
+    portENTER_CRITICAL(&writerMux);
+    __atomic_store_n(&sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    return &current;
+}
+
+void state_write_end(void)
+{
+    __atomic_store_n(&sequence, sequence + 1, __ATOMIC_RELEASE);
+    portEXIT_CRITICAL(&writerMux);
+}
+
+float state_capacity_limit(const tank_state_t *tank)
+{
+    if (tank->capacityLimitLitres > 0 && tank->capacityLitres > 0)
+        return tank->capacityLimitLitres / tank->capacityLitres * 100;
+    return tank->storageCapacityLimit;
+}
+
+#define TANK_PARAM(field, type, min, max) {#field, offsetof(tank_state_t, field), type, true, min, max}
+#define GLOBAL_PARAM(field, type, min, max) {#field, offsetof(state_t, field), type, false, min, max}
+
+static const state_param_t params[] = {
+    TANK_PARAM(temperatureLimit, STATE_PARAM_FLOAT, STATE_TEMPERATURE_LIMIT_MIN, STATE_TEMPERATURE_LIMIT_MAX),
+    TANK_PARAM(storageCapacityLimit, STATE_PARAM_INT, STATE_CAPACITY_LIMIT_MIN, STATE_CAPACITY_LIMIT_MAX),
+    TANK_PARAM(capacityLimitLitres, STATE_PARAM_FLOAT, 0, 1000000),
+    TANK_PARAM(lowLevelLitres, STATE_PARAM_FLOAT, 0, 1000000),
+    TANK_PARAM(tankHeightCm, STATE_PARAM_FLOAT, 5, 1000),
+    TANK_PARAM(shape, STATE_PARAM_INT, 0, GEOMETRY_SHAPES - 1),
+    TANK_PARAM(diameterCm, STATE_PARAM_FLOAT, 1, 1000),
+    TANK_PARAM(lengthCm, STATE_PARAM_FLOAT, 1, 5000),
+    TANK_PARAM(coneHeightCm, STATE_PARAM_FLOAT, 0, 1000),
+    GLOBAL_PARAM(sampleMinMs, STATE_PARAM_U32, 1000, 60000),
+    GLOBAL_PARAM(sampleMaxMs, STATE_PARAM_U32, 1000, 600000),
+    GLOBAL_PARAM(debounceMs, STATE_PARAM_U32, 10, 2000),
+    GLOBAL_PARAM(levelRateNoise, STATE_PARAM_FLOAT, 0.001f, 100),
+    GLOBAL_PARAM(levelMeasureNoise, STATE_PARAM_FLOAT, 0.001f, 100),
+};
+
+const state_param_t *state_params(int *count)
+{
+    *count = sizeof(params) / sizeof(params[0]);
+    return params;
+}
+
+bool state_param_parse(const char *text, state_param_update_t *update)
+{
+    const char *bracket = strchr(text, '[');
+    size_t len = bracket != NULL ? (size_t)(bracket - text) : strlen(text);
+    int number = 1;
+    if (bracket != NULL)
+    {
+        char *end;
+        number = strtol(bracket + 1, &end, 10);
+        if (end == bracket + 1 || strcmp(end, "]") != 0)
+            return false;
+    }
+
+    for (size_t i = 0; i < sizeof(params) / sizeof(params[0]); i++)
+    {
+        if (strncmp(params[i].name, text, len) != 0 || params[i].name[len] != '\0')
+            continue;
+        if (bracket != NULL && (!params[i].perTank || number < 1 || number > CONFIG_APP_TANK_COUNT))
+            return false;
+        update->param = &params[i];
+        update->tank = number - 1;
+        return true;
+    }
+    return false;
+}
+
+static void *param_field(state_t *state, const state_param_t *param, int tank)
+{
+    uint8_t *base = param->perTank ? (uint8_t *)&state->tanks[tank] : (uint8_t *)state;
+    return base + param->offset;
+}
+
+float state_param_get(const state_t *state, const state_param_t *param, int tank)
+{
+    const void *field = param_field((state_t *)state, param, tank);
+    switch (param->type)
+    {
+    case STATE_PARAM_INT:
+        return *(const int *)field;
+    case STATE_PARAM_U32:
+        return *(const uint32_t *)field;
+    default:
+        return *(const float *)field;
+    }
+}
+
+int state_params_set(const state_param_update_t *updates, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        const state_param_update_t *u = &updates[i];
+        if (!(u->value >= u->param->min && u->value <= u->param->max))
+            return i;
+        if (u->param->perTank && (u->tank < 0 || u->tank >= CONFIG_APP_TANK_COUNT))
+            return i;
+    }
+
+    state_t *state = state_write_begin();
+    for (int i = 0; i < count; i++)
+    {
+        void *field = param_field(state, updates[i].param, updates[i].tank);
+        switch (updates[i].param->type)
+        {
+        case STATE_PARAM_INT:
+            *(int *)field = (int)updates[i].value;
+            break;
+        case STATE_PARAM_U32:
+            *(uint32_t *)field = (uint32_t)updates[i].value;
+            break;
+        default:
+            *(float *)field = updates[i].value;
+            break;
+        }
+    }
+    state_write_end();
+    return -1;
+}
@@ -0,0 +1,108 @@
+#ifndef MAIN_STATE_H_
+#define MAIN_STATE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sdkconfig.h>
+
+// Faixas aceitas para as configuracoes
+#define STATE_TEMPERATURE_LIMIT_MIN 10
+#define STATE_TEMPERATURE_LIMIT_MAX 50
+#define STATE_CAPACITY_LIMIT_MIN 10
+#define STATE_CAPACITY_LIMIT_MAX 100
+
+// Medidas e configuracoes de um reservatorio
+typedef struct
+{
+    // Medidas
+    float waterDistance; // cm
+    float waterPercent;  // % do volume
+    float waterLitres;
+    float capacityLitres; // volume cheio pelo perfil atual
+    float waterTemperature;
+    float levelRate; // %/min estimado, positivo enchendo
+    int32_t etaSeconds; // ate encher ou esvaziar, -1 se o nivel estiver estavel
+    bool pumpOn;
+    bool heaterOn;
+    uint8_t alarms; // ANOMALY_*
+    uint8_t faults; // HEALTH_*
+    // Configuracoes
+    float temperatureLimit;
+    int storageCapacityLimit; // % do volume
+    float capacityLimitLitres; // substitui storageCapacityLimit quando > 0
+    float lowLevelLitres;      // alarme abaixo deste volume, 0 desliga
+    // Perfil (geometry.h); o sensor fica na borda superior
+    float tankHeightCm; // do sensor ao fundo
+    int shape;          // geometry_shape_t
+    float diameterCm;
+    float lengthCm;     // cilindro deitado
+    float coneHeightCm; // fundo conico
+} tank_state_t;
+
+// Estado compartilhado do controlador: medidas e configuracoes.
+// Publicado por seqlock: leitores em qualquer core obtem uma copia
+// consistente sem mutex, escritores sao serializados entre si.
+typedef struct
+{
+    int64_t timestamp; // inicio do ciclo de aquisicao, esp_timer_get_time()
+    tank_state_t tanks[CONFIG_APP_TANK_COUNT];
+    int mode;
+    int tank; // reservatorio mostrado e ajustado pelos botoes
+    // Parametros ajustaveis em campo, lidos a cada ciclo pelas malhas
+    uint32_t sampleMinMs; // periodo de amostragem mais rapido
+    uint32_t sampleMaxMs; // periodo de amostragem mais lento
+    uint32_t debounceMs;
+    float levelRateNoise;    // (%/min)^2/min, ver level_init
+    float levelMeasureNoise; // %^2
+} state_t;
+
+typedef enum
+{
+    STATE_PARAM_FLOAT,
+    STATE_PARAM_INT,
+    STATE_PARAM_U32,
+} state_param_type_t;
+
+// Campo de state_t alteravel por nome, com a faixa aceita
+typedef struct
+{
+    const char *name;
+    size_t offset; // em tank_state_t quando perTank
+    state_param_type_t type;
+    bool perTank;
+    float min;
+    float max;
+} state_param_t;
+
+typedef struct
+{
+    const state_param_t *param;
+    int tank; // indice a partir de 0, ignorado sem perTank
+    float value;
+} state_param_update_t;
+
+void state_init(const state_t *initial);
+void state_get(state_t *snapshot);
+
+// Toda alteracao fica entre begin e end, e deve ser curta: os leitores
+// repetem a copia enquanto uma escrita estiver em andamento.
+state_t *state_write_begin(void);
+void state_write_end(void);
+
+// Limite de acionamento da bomba em % do volume, de litros ou de %
+float state_capacity_limit(const tank_state_t *tank);
+
+// Tabela de parametros alteraveis pelas interfaces remotas
+const state_param_t *state_params(int *count);
+float state_param_get(const state_t *state, const state_param_t *param, int tank);
+
+// Interpreta "nome" ou "nome[N]", com N o numero do reservatorio a partir
+// de 1 (o mesmo do display). Sem [N] vale o primeiro reservatorio.
+bool state_param_parse(const char *text, state_param_update_t *update);
+
+// Valida todos os valores e aplica em uma unica escrita, ou nenhum.
+// Retorna o indice do primeiro valor recusado, ou -1 se tudo foi aplicado.
+int state_params_set(const state_param_update_t *updates, int count);
+
+#endif /* MAIN_STATE_H_ */
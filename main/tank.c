@@ -0,0 +1,189 @@
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <esp_log.h>
+#include <esp_efuse.h>
+#include <esp_efuse_table.h>
+#include "tank.h"
+
+#define TANK_TAG "TANK"
+
+// Tabela de reservatorios da placa; os CONFIG_APP_TANK_COUNT primeiros
+// sao usados. Os pinos dos reservatorios 2 a 4 sao sugestoes livres na
+// placa de referencia. Com a ROM zerada o canal recebe o proximo DS18B20
+// achado no barramento; com varios reservatorios prefira fixar a ROM
+// (listada no log pelo comando rescan do console). Sensores ultrassonicos
+// redundantes entram em rangers, ate CONFIG_APP_ACQ_RANGERS por reservatorio.
+// Sem pumpSafe/heaterSafe a bomba e a resistencia desligam com o sensor em
+// falha; uma bomba de recalque que nao pode parar usaria .pumpSafe = true.
+// Os ecos dos reservatorios 3 e 4 ficam em GPIO36/39 por falta de outras
+// entradas livres. Pela errata 3.11 do ESP32, o ADC, o Wi-Fi e o sono leve
+// puxam esses pinos para baixo por ~80 ns; o pico no meio do eco e
+// descartado pela interrupcao (ranging.c), mas um pino que nao seja 36/39
+// deve ser preferido numa placa nova.
+const tank_config_t tankConfigs[TANK_COUNT] = {
+    {
+        .name = "Caixa 1",
+        .sensors = {.rangers = {{.trigger = GPIO_NUM_13, .echo = GPIO_NUM_35}}, .rangerCount = 1},
+        .pump = GPIO_NUM_10,
+        .heater = GPIO_NUM_9,
+        .geometry = {.shape = GEOMETRY_CYLINDER, .heightCm = 20, .diameterCm = 15},
+        .capacityLimit = 10,
+        .temperatureLimit = 10,
+    },
+#if TANK_COUNT > 1
+    {
+        .name = "Caixa 2",
+        .sensors = {.rangers = {{.trigger = GPIO_NUM_19, .echo = GPIO_NUM_34}}, .rangerCount = 1},
+        .pump = GPIO_NUM_23,
+        .heater = GPIO_NUM_21,
+        .geometry = {.shape = GEOMETRY_CYLINDER, .heightCm = 20, .diameterCm = 15},
+        .capacityLimit = 10,
+        .temperatureLimit = 10,
+    },
+#endif
+#if TANK_COUNT > 2
+    {
+        .name = "Caixa 3",
+        .sensors = {.rangers = {{.trigger = GPIO_NUM_22, .echo = GPIO_NUM_36}}, .rangerCount = 1},
+        .pump = GPIO_NUM_5,
+        .heater = GPIO_NUM_NC,
+        .geometry = {.shape = GEOMETRY_CYLINDER, .heightCm = 20, .diameterCm = 15},
+        .capacityLimit = 10,
+        .temperatureLimit = 10,
+    },
+#endif
+#if TANK_COUNT > 3
+    {
+        .name = "Caixa 4",
+        .sensors = {.rangers = {{.trigger = GPIO_NUM_2, .echo = GPIO_NUM_39}}, .rangerCount = 1},
+        // GPIO12 (MTDI) escolhe a tensao da flash no reset: um rele que o
+        // puxe para cima seleciona 1.8 V e a placa nao inicia. So com a
+        // tensao fixada por efuse (APP_TANK4_PUMP_GPIO12); sem ela o
+        // reservatorio 4 fica sem bomba, so com medidas e alarmes.
+#if CONFIG_APP_TANK4_PUMP_GPIO12
+        .pump = GPIO_NUM_12,
+#else
+        .pump = GPIO_NUM_NC,
+#endif
+        .heater = GPIO_NUM_NC,
+        .geometry = {.shape = GEOMETRY_CYLINDER, .heightCm = 20, .diameterCm = 15},
+        .capacityLimit = 10,
+        .temperatureLimit = 10,
+    },
+#endif
+};
+
+static void setup_output(gpio_num_t pin)
+{
+    if (pin == GPIO_NUM_NC)
+        return;
+    esp_rom_gpio_pad_select_gpio(pin);
+    gpio_set_direction(pin, GPIO_MODE_OUTPUT);
+}
+
+void tank_setup(const tank_config_t *config)
+{
+    if (config->pump == GPIO_NUM_12 && !(esp_efuse_read_field_bit(ESP_EFUSE_SDIO_FORCE) &&
+                                         esp_efuse_read_field_bit(ESP_EFUSE_SDIO_TIEH)))
+        ESP_LOGE(TANK_TAG, "%s: bomba em GPIO12 sem VDD_SDIO fixado em 3.3 V por efuse; "
+                           "o rele pode impedir o boot (espefuse.py set_flash_voltage 3.3V)", config->name);
+    setup_output(config->pump);
+    setup_output(config->heater);
+
+    // A tabela da configuracao e a inicial do reservatorio
+    const geometry_profile_t *geometry = &config->geometry;
+    if (geometry->table != NULL && !tank_set_table(config - tankConfigs, geometry->table, geometry->tableCount))
+        ESP_LOGE(TANK_TAG, "%s: tabela de arqueacao invalida", config->name);
+}
+
+// As saidas acionam os reles em nivel baixo
+void tank_set_pump(const tank_config_t *config, bool on)
+{
+    if (config->pump != GPIO_NUM_NC)
+        gpio_set_level(config->pump, on ? 0 : 1);
+}
+
+void tank_set_heater(const tank_config_t *config, bool on)
+{
+    if (config->heater != GPIO_NUM_NC)
+        gpio_set_level(config->heater, on ? 0 : 1);
+}
+
+// Tabelas de arqueacao em execucao, trocadas inteiras sob o lock
+static geometry_point_t tables[TANK_COUNT][GEOMETRY_POINTS_MAX];
+static int tableCounts[TANK_COUNT];
+static uint32_t tableVersions[TANK_COUNT];
+static portMUX_TYPE tableMux = portMUX_INITIALIZER_UNLOCKED;
+// Usados so pela tarefa de aquisicao, fora da pilha
+static geometry_point_t scratchPoints[GEOMETRY_POINTS_MAX];
+static geometry_lut_t scratchLut;
+
+bool tank_set_table(int tank, const geometry_point_t *points, int count)
+{
+    geometry_profile_t profile = {.shape = GEOMETRY_TABLE, .table = points, .tableCount = count};
+    geometry_lut_t lut;
+    if (tank < 0 || tank >= TANK_COUNT || !geometry_build(&lut, &profile))
+        return false;
+
+    portENTER_CRITICAL(&tableMux);
+    memcpy(tables[tank], points, count * sizeof(geometry_point_t));
+    tableCounts[tank] = count;
+    tableVersions[tank]++;
+    portEXIT_CRITICAL(&tableMux);
+    return true;
+}
+
+int tank_get_table(int tank, geometry_point_t *points)
+{
+    portENTER_CRITICAL(&tableMux);
+    int count = tableCounts[tank];
+    memcpy(points, tables[tank], count * sizeof(geometry_point_t));
+    portEXIT_CRITICAL(&tableMux);
+    return count;
+}
+
+bool tank_geometry_update(tank_t *t, const tank_state_t *state)
+{
+    geometry_profile_t profile = {
+        .shape = state->shape,
+        .heightCm = state->tankHeightCm,
+        .diameterCm = state->diameterCm,
+        .lengthCm = state->lengthCm,
+        .coneHeightCm = state->coneHeightCm,
+    };
+
+    portENTER_CRITICAL(&tableMux);
+    uint32_t version = tableVersions[t->index];
+    portEXIT_CRITICAL(&tableMux);
+
+    const geometry_profile_t *built = &t->built;
+    bool changed = profile.shape != built->shape ||
+                   profile.heightCm != built->heightCm || profile.diameterCm != built->diameterCm ||
+                   profile.lengthCm != built->lengthCm || profile.coneHeightCm != built->coneHeightCm ||
+                   (profile.shape == GEOMETRY_TABLE && version != t->tableVersion);
+    if (!changed)
+        return t->lutValid;
+
+    // A tentativa e registrada mesmo se falhar, para nao repetir o erro a
+    // cada ciclo; a tabela anterior continua em uso
+    t->built = profile;
+    t->tableVersion = version;
+    if (profile.shape == GEOMETRY_TABLE)
+    {
+        profile.tableCount = tank_get_table(t->index, scratchPoints);
+        profile.table = scratchPoints;
+    }
+    if (!geometry_build(&scratchLut, &profile))
+    {
+        ESP_LOGE(TANK_TAG, "%s: perfil %d invalido, mantida a tabela anterior", t->config->name, profile.shape);
+        return t->lutValid;
+    }
+    t->lut = scratchLut;
+    t->lutValid = true;
+    // O percentual muda de escala com o perfil; o filtro recomeca da
+    // proxima medida em vez de tratar o salto como vazao
+    t->levelEst.primed = false;
+    ESP_LOGI(TANK_TAG, "%s: perfil %d, capacidade %d L", t->config->name, profile.shape,
+             (int)geometry_capacity(&t->lut));
+    return true;
+}
@@ -0,0 +1,69 @@
+#ifndef MAIN_TANK_H_
+#define MAIN_TANK_H_
+
+#include <stdbool.h>
+#include <sdkconfig.h>
+#include <driver/gpio.h>
+#include "acq.h"
+#include "rate.h"
+#include "level.h"
+#include "anomaly.h"
+#include "geometry.h"
+#include "health.h"
+#include "state.h"
+
+#define TANK_COUNT CONFIG_APP_TANK_COUNT
+
+// Ligacoes e valores iniciais de um reservatorio
+typedef struct
+{
+    const char *name;
+    acq_channel_t sensors;
+    gpio_num_t pump;   // saida da bomba, ativa em nivel baixo; GPIO_NUM_NC sem bomba
+    gpio_num_t heater; // saida da resistencia, GPIO_NUM_NC se nao houver
+    // Perfil inicial; heightCm vai do sensor ao fundo. A tabela de
+    // arqueacao pode ser trocada em execucao com tank_set_table.
+    geometry_profile_t geometry;
+    int capacityLimit;      // %
+    float temperatureLimit; // C
+    // Estados assumidos com o sensor da malha em falha (false: desligado)
+    bool pumpSafe;
+    bool heaterSafe;
+} tank_config_t;
+
+// Instancia em execucao: configuracao e estado das malhas de controle,
+// usados apenas pela tarefa de aquisicao
+typedef struct
+{
+    int index;
+    const tank_config_t *config;
+    rate_ctl_t rateCtl;
+    level_est_t levelEst;
+    anomaly_det_t anomalyDet;
+    health_sensor_t levelHealth;
+    health_sensor_t temperatureHealth; // so com resistencia
+    bool fineTemperature; // perto do limite: DS18B20 em 12 bits
+    // Tabela de volume e o perfil do qual foi montada; built.shape comeca
+    // em GEOMETRY_SHAPES para forcar a primeira montagem
+    geometry_lut_t lut;
+    geometry_profile_t built;
+    uint32_t tableVersion;
+    bool lutValid;
+} tank_t;
+
+extern const tank_config_t tankConfigs[TANK_COUNT];
+
+void tank_setup(const tank_config_t *config);
+void tank_set_pump(const tank_config_t *config, bool on);
+void tank_set_heater(const tank_config_t *config, bool on);
+
+// Remonta a tabela de volume se o perfil em state mudou; retorna false
+// enquanto nao houver tabela valida. Chamado pela tarefa de aquisicao.
+bool tank_geometry_update(tank_t *t, const tank_state_t *state);
+
+// Tabela de arqueacao usada com GEOMETRY_TABLE. A nova tabela e validada
+// antes de substituir a atual e vale a partir do proximo ciclo.
+bool tank_set_table(int tank, const geometry_point_t *points, int count);
+int tank_get_table(int tank, geometry_point_t *points);
+
+#endif /* MAIN_TANK_H_ */
@@ -0,0 +1,217 @@
+#include <sdkconfig.h>
+#if CONFIG_APP_TELEMETRY
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <mqtt_client.h>
+#include "telemetry.h"
+#include "history.h"
+#include "state.h"
+#include "sched.h"
+#include "wifi.h"
+
+#define TELEMETRY_TAG "TELEMETRY"
+#define TELEMETRY_SAMPLE_MAX 48 // maior texto de uma amostra no payload
+#define TELEMETRY_PAYLOAD_MAX (CONFIG_APP_TELEMETRY_BATCH * TELEMETRY_SAMPLE_MAX + 48)
+#define TELEMETRY_COMMAND_MAX 128
+// Sem PUBLISHED nem DELETED neste prazo o lote e dado como perdido e
+// remontado; o broker pode receber o trecho duas vezes, o seq desfaz
+#define TELEMETRY_INFLIGHT_TIMEOUT_US (120 * 1000000LL)
+
+static esp_mqtt_client_handle_t client;
+static char dataTopic[64];
+static char commandTopic[64];
+static char payload[TELEMETRY_PAYLOAD_MAX];
+static void (*changeCallback)(void);
+
+// Lote em transito: o cursor so avanca quando o broker confirma
+static portMUX_TYPE batchMux = portMUX_INITIALIZER_UNLOCKED;
+static volatile bool connected;
+static uint32_t cursor;
+static bool inflight;
+static int inflightId;
+static uint32_t inflightEnd;
+static int64_t inflightSince;
+
+static void telemetry_job(void *arg);
+
+static sched_task_t telemetryTask = {
+    .name = "telemetry_task",
+    .job = telemetry_job,
+    .periodMs = CONFIG_APP_TELEMETRY_INTERVAL_S * 1000,
+    .stackSize = 4096,
+    .priority = CONFIG_APP_UI_PRIORITY,
+    .core = CONFIG_APP_UI_CORE,
+};
+
+// Monta o lote a partir de first; retorna o tamanho do payload e em
+// *count quantas amostras couberam
+static int build_batch(uint32_t first, uint32_t *count)
+{
+    int len = snprintf(payload, sizeof(payload), "{\"seq\":%u,\"up\":%u,\"s\":[",
+                       (unsigned)first, (unsigned)(esp_timer_get_time() / 1000000));
+    uint32_t n = 0;
+    for (; n < *count; n++)
+    {
+        history_sample_t s;
+        if (!history_get(first + n, &s) || len + TELEMETRY_SAMPLE_MAX + 2 >= (int)sizeof(payload))
+            break;
+        len += snprintf(&payload[len], sizeof(payload) - len, "%s[%u,%d,%d,%d,%u,%u]", n > 0 ? "," : "",
+                        (unsigned)s.time, s.level, s.temperature, s.rate, s.flags, s.alarms);
+    }
+    len += snprintf(&payload[len], sizeof(payload) - len, "]}");
+    *count = n;
+    return len;
+}
+
+// Envia no maximo um lote por execucao. Com atraso acumulado o periodo cai
+// para CONFIG_APP_TELEMETRY_DRAIN_MS ate esvaziar, limitando a taxa.
+static void telemetry_job(void *arg)
+{
+    uint32_t head = history_head();
+    uint32_t tail = history_tail();
+
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&batchMux);
+    bool expired = inflight && now - inflightSince > TELEMETRY_INFLIGHT_TIMEOUT_US;
+    if (expired)
+        inflight = false;
+    bool busy = !connected || inflight;
+    uint32_t first = cursor;
+    uint32_t lost = 0;
+    if (first < tail)
+    {
+        lost = tail - first;
+        first = tail;
+        cursor = tail;
+    }
+    portEXIT_CRITICAL(&batchMux);
+
+    if (expired)
+        ESP_LOGW(TELEMETRY_TAG, "Lote %d sem confirmacao, reenviando", inflightId);
+    if (lost > 0)
+        ESP_LOGW(TELEMETRY_TAG, "%u amostras sobrescritas antes do envio", (unsigned)lost);
+
+    uint32_t count = head - first;
+    if (count > CONFIG_APP_TELEMETRY_BATCH)
+        count = CONFIG_APP_TELEMETRY_BATCH;
+    if (!busy && count > 0)
+    {
+        int len = build_batch(first, &count);
+        // enqueue nao bloqueia: o envio fica com a tarefa do cliente MQTT
+        int msgId = esp_mqtt_client_enqueue(client, dataTopic, payload, len, 1, 0, true);
+        if (msgId >= 0)
+        {
+            portENTER_CRITICAL(&batchMux);
+            inflight = true;
+            inflightId = msgId;
+            inflightEnd = first + count;
+            inflightSince = now;
+            portEXIT_CRITICAL(&batchMux);
+        }
+    }
+
+    bool backlog = head - first > count;
+    sched_set_period(&telemetryTask, backlog && connected ? CONFIG_APP_TELEMETRY_DRAIN_MS : CONFIG_APP_TELEMETRY_INTERVAL_S * 1000);
+}
+
+static void batch_done(int msgId, bool delivered)
+{
+    portENTER_CRITICAL(&batchMux);
+    if (inflight && msgId == inflightId)
+    {
+        if (delivered)
+            cursor = inflightEnd;
+        inflight = false;
+    }
+    portEXIT_CRITICAL(&batchMux);
+}
+
+// Comandos "chave=valor" separados por ';' ou quebra de linha, com os
+// nomes da tabela de parametros de state.c (ver state_param_parse)
+static void handle_command(const esp_mqtt_event_t *event)
+{
+    if (event->data_len != event->total_data_len || event->data_len >= TELEMETRY_COMMAND_MAX)
+    {
+        ESP_LOGW(TELEMETRY_TAG, "Comando muito longo ignorado");
+        return;
+    }
+    char text[TELEMETRY_COMMAND_MAX];
+    memcpy(text, event->data, event->data_len);
+    text[event->data_len] = '\0';
+
+    bool changed = false;
+    char *save;
+    for (char *item = strtok_r(text, ";\n", &save); item != NULL; item = strtok_r(NULL, ";\n", &save))
+    {
+        char *value = strchr(item, '=');
+        if (value == NULL)
+            continue;
+        *value++ = '\0';
+        state_param_update_t update;
+        bool ok = state_param_parse(item, &update);
+        if (ok)
+        {
+            update.value = strtof(value, NULL);
+            ok = state_params_set(&update, 1) < 0;
+        }
+        if (ok)
+            changed = true;
+        ESP_LOGI(TELEMETRY_TAG, "Comando %s=%s %s", item, value, ok ? "aplicado" : "recusado");
+    }
+    if (changed && changeCallback != NULL)
+        changeCallback();
+}
+
+static void mqtt_event(void *arg, esp_event_base_t base, int32_t id, void *data)
+{
+    esp_mqtt_event_handle_t event = data;
+    switch ((esp_mqtt_event_id_t)id)
+    {
+    case MQTT_EVENT_CONNECTED:
+        connected = true;
+        esp_mqtt_client_subscribe(client, commandTopic, 1);
+        ESP_LOGI(TELEMETRY_TAG, "Conectado ao broker");
+        break;
+    case MQTT_EVENT_DISCONNECTED:
+        // O lote em transito continua na outbox e e reenviado ao reconectar
+        connected = false;
+        break;
+    case MQTT_EVENT_PUBLISHED:
+        batch_done(event->msg_id, true);
+        break;
+    case MQTT_EVENT_DELETED:
+        // Expirou na outbox: o mesmo trecho e montado de novo
+        batch_done(event->msg_id, false);
+        break;
+    case MQTT_EVENT_DATA:
+        if (event->topic_len == (int)strlen(commandTopic) && strncmp(event->topic, commandTopic, event->topic_len) == 0)
+            handle_command(event);
+        break;
+    default:
+        break;
+    }
+}
+
+void telemetry_start(void (*onChange)(void))
+{
+    if (!wifi_start())
+        return;
+    changeCallback = onChange;
+    snprintf(dataTopic, sizeof(dataTopic), "%s/telemetry", CONFIG_APP_MQTT_TOPIC);
+    snprintf(commandTopic, sizeof(commandTopic), "%s/cmd", CONFIG_APP_MQTT_TOPIC);
+
+    esp_mqtt_client_config_t config = {
+        .uri = CONFIG_APP_MQTT_URI,
+    };
+    client = esp_mqtt_client_init(&config);
+    esp_mqtt_client_register_event(client, MQTT_EVENT_ANY, mqtt_event, NULL);
+    esp_mqtt_client_start(client);
+
+    // Envia desde a amostra mais antiga ainda no historico
+    cursor = history_tail();
+    sched_start(&telemetryTask);
+}
+#endif
@@ -0,0 +1,15 @@
+#ifndef MAIN_TELEMETRY_H_
+#define MAIN_TELEMETRY_H_
+
+// Publica o historico em lotes via MQTT (QoS 1) no topico
+// CONFIG_APP_MQTT_TOPIC/telemetry e aceita configuracoes em
+// CONFIG_APP_MQTT_TOPIC/cmd. Payload de cada lote:
+//   {"seq":<primeira sequencia>,"up":<s desde o boot>,
+//    "s":[[t,nivel,temperatura,vazao,flags,alarmes],...]}
+// com os valores escalados como em history_sample_t; o reservatorio da
+// amostra vai nos bits altos de flags (HISTORY_TANK).
+//
+// onChange e chamado apos um comando aceito.
+void telemetry_start(void (*onChange)(void));
+
+#endif /* MAIN_TELEMETRY_H_ */
@@ -0,0 +1,139 @@
+#include <string.h>
+#include "widgets.h"
+
+void screen_init(screen_t *screen, SSD1306_t *dev, widget_t *widgets, int count)
+{
+    screen->dev = dev;
+    screen->widgets = widgets;
+    screen->count = count;
+    screen->refresh = NULL;
+    screen->_feed = NULL;
+    screen->_lock = xSemaphoreCreateMutex();
+    screen_invalidate(screen);
+}
+
+// Forca o redesenho de todos os widgets na proxima atualizacao
+void screen_invalidate(screen_t *screen)
+{
+    for (int i = 0; i < screen->count; i++)
+    {
+        screen->widgets[i]._drawn = false;
+        screen->widgets[i]._len = 0;
+    }
+}
+
+// Troca o conjunto de widgets exibido, limpando o display uma unica vez
+void screen_show(screen_t *screen, widget_t *widgets, int count)
+{
+    xSemaphoreTake(screen->_lock, portMAX_DELAY);
+    bool cleared = false;
+    if (screen->_feed != NULL)
+    {
+        // O ticker redesenha a tela ao parar: com as paginas zeradas esse
+        // redesenho ja e a limpeza
+        for (int page = 0; page < SSD1306_RAM_PAGES; page++)
+            memset(screen->dev->_page[page]._segs, 0, sizeof(screen->dev->_page[page]._segs));
+        ssd1306_ticker_stop(screen->dev);
+        screen->_feed = NULL;
+        cleared = true;
+    }
+    if (screen->widgets != widgets || cleared)
+    {
+        if (!cleared)
+            ssd1306_clear_screen(screen->dev, false);
+        screen->widgets = widgets;
+        screen->count = count;
+        screen_invalidate(screen);
+    }
+    xSemaphoreGive(screen->_lock);
+}
+
+void screen_show_feed(screen_t *screen, screen_feed_t feed)
+{
+    xSemaphoreTake(screen->_lock, portMAX_DELAY);
+    if (screen->_feed != feed)
+    {
+        // O ticker limpa a GDDRAM inteira; as linhas guardadas pela fonte
+        // entram na proxima atualizacao
+        ssd1306_ticker_init(screen->dev);
+        screen->_feed = feed;
+        screen->_cursor = 0;
+        screen->widgets = NULL;
+        screen->count = 0;
+    }
+    xSemaphoreGive(screen->_lock);
+}
+
+static int widget_render(widget_t *widget, char *text)
+{
+    int size = WIDGET_TEXT_MAX - widget->col + 1;
+    int len = 0;
+    if (widget->label != NULL)
+    {
+        for (const char *c = widget->label; *c != '\0' && len < size - 1; c++)
+            text[len++] = *c;
+    }
+    if (widget->format != NULL && len < size - 1)
+    {
+        int n = widget->format(&text[len], size - len, widget->value);
+        len += n < 0 ? 0 : n;
+        if (len >= size)
+            len = size - 1;
+    }
+    text[len] = '\0';
+    return len;
+}
+
+// Envia ao display apenas o trecho do texto que mudou
+static void widget_draw(screen_t *screen, widget_t *widget, const char *text, int len)
+{
+    int end = len > widget->_len ? len : widget->_len;
+    int first = 0;
+    int last = end - 1;
+    if (widget->_drawn)
+    {
+        while (first < end && first < len && first < widget->_len && text[first] == widget->_text[first])
+            first++;
+        while (last >= first && last < len && last < widget->_len && text[last] == widget->_text[last])
+            last--;
+    }
+    if (last >= first)
+    {
+        // Caracteres que sobraram do texto anterior viram espaco
+        char span[WIDGET_TEXT_MAX];
+        for (int i = first; i <= last; i++)
+            span[i - first] = i < len ? text[i] : ' ';
+        ssd1306_display_text_at(screen->dev, widget->page, widget->col + first, span, last - first + 1, false);
+    }
+    memcpy(widget->_text, text, len + 1);
+    widget->_len = len;
+    widget->_drawn = true;
+}
+
+void screen_update(screen_t *screen)
+{
+    char text[WIDGET_TEXT_MAX + 1];
+
+    xSemaphoreTake(screen->_lock, portMAX_DELAY);
+    if (screen->refresh != NULL)
+        screen->refresh();
+    if (screen->_feed != NULL)
+    {
+        // Uma pagina enviada por linha nova
+        int len;
+        while ((len = screen->_feed(&screen->_cursor, text, sizeof(text))) >= 0)
+            ssd1306_ticker_text(screen->dev, text, len, false);
+    }
+    for (int i = 0; i < screen->count; i++)
+    {
+        widget_t *widget = &screen->widgets[i];
+        // Rotulos estaticos so sao desenhados uma vez
+        if (widget->_drawn && widget->format == NULL)
+            continue;
+        int len = widget_render(widget, text);
+        if (widget->_drawn && len == widget->_len && memcmp(text, widget->_text, len) == 0)
+            continue;
+        widget_draw(screen, widget, text, len);
+    }
+    xSemaphoreGive(screen->_lock);
+}
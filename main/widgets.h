@@ -0,0 +1,57 @@
+#ifndef MAIN_WIDGETS_H_
+#define MAIN_WIDGETS_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "ssd1306.h"
+
+#define WIDGET_TEXT_MAX 16 // caracteres por linha do display
+
+// Escreve o valor formatado em buf e retorna o tamanho do texto
+typedef int (*widget_format_t)(char *buf, size_t size, const volatile void *value);
+
+typedef struct
+{
+    int page;               // linha do display
+    int col;                // coluna inicial, em caracteres
+    const char *label;      // texto fixo antes do valor (NULL se nao houver)
+    widget_format_t format; // NULL para um rotulo estatico
+    const volatile void *value; // valor vinculado, repassado ao format
+    char _text[WIDGET_TEXT_MAX + 1];
+    int _len;
+    bool _drawn;
+} widget_t;
+
+// Chamado antes de formatar os widgets, com o lock da tela
+typedef void (*screen_refresh_t)(void);
+
+// Fonte de linhas da tela de rolagem: copia em buf a linha seguinte a
+// *cursor e o avanca, ou retorna -1 sem linhas novas
+typedef int (*screen_feed_t)(uint32_t *cursor, char *buf, size_t size);
+
+typedef struct
+{
+    SSD1306_t *dev;
+    widget_t *widgets;
+    int count;
+    screen_refresh_t refresh; // opcional: captura os valores vinculados
+    screen_feed_t _feed;      // tela de rolagem no lugar dos widgets
+    uint32_t _cursor;
+    SemaphoreHandle_t _lock;
+} screen_t;
+
+#define WIDGET_LABEL(p, text) {.page = (p), .col = 0, .label = (text)}
+#define WIDGET_FIELD(p, lbl, fmt, val) {.page = (p), .col = 0, .label = (lbl), .format = (fmt), .value = (val)}
+
+void screen_init(screen_t *screen, SSD1306_t *dev, widget_t *widgets, int count);
+void screen_update(screen_t *screen);
+void screen_invalidate(screen_t *screen);
+void screen_show(screen_t *screen, widget_t *widgets, int count);
+// Troca os widgets por linhas que entram por baixo e empurram as demais
+// para cima, sem redesenhar a tela (ssd1306_ticker_*)
+void screen_show_feed(screen_t *screen, screen_feed_t feed);
+
+#endif /* MAIN_WIDGETS_H_ */
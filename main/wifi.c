@@ -0,0 +1,75 @@
+#include <string.h>
+#include <esp_log.h>
+#include <esp_wifi.h>
+#include <esp_event.h>
+#include <esp_netif.h>
+#include <nvs_flash.h>
+#include "wifi.h"
+
+#define WIFI_TAG "WIFI"
+
+static volatile bool connected;
+static bool started;
+
+static void wifi_event(void *arg, esp_event_base_t base, int32_t id, void *data)
+{
+    if (base == WIFI_EVENT && id == WIFI_EVENT_STA_START)
+    {
+        esp_wifi_connect();
+    }
+    else if (base == WIFI_EVENT && id == WIFI_EVENT_STA_DISCONNECTED)
+    {
+        connected = false;
+        esp_wifi_connect();
+    }
+    else if (base == IP_EVENT && id == IP_EVENT_STA_GOT_IP)
+    {
+        const ip_event_got_ip_t *event = data;
+        ESP_LOGI(WIFI_TAG, "Conectado, IP " IPSTR, IP2STR(&event->ip_info.ip));
+        connected = true;
+    }
+}
+
+bool wifi_start(void)
+{
+    if (started)
+        return true;
+    if (strlen(CONFIG_APP_WIFI_SSID) == 0)
+    {
+        ESP_LOGW(WIFI_TAG, "Nenhuma rede configurada");
+        return false;
+    }
+
+    esp_err_t err = nvs_flash_init();
+    if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND)
+    {
+        ESP_ERROR_CHECK(nvs_flash_erase());
+        err = nvs_flash_init();
+    }
+    ESP_ERROR_CHECK(err);
+    ESP_ERROR_CHECK(esp_netif_init());
+    ESP_ERROR_CHECK(esp_event_loop_create_default());
+    esp_netif_create_default_wifi_sta();
+
+    wifi_init_config_t init = WIFI_INIT_CONFIG_DEFAULT();
+    ESP_ERROR_CHECK(esp_wifi_init(&init));
+    ESP_ERROR_CHECK(esp_event_handler_instance_register(WIFI_EVENT, ESP_EVENT_ANY_ID, wifi_event, NULL, NULL));
+    ESP_ERROR_CHECK(esp_event_handler_instance_register(IP_EVENT, IP_EVENT_STA_GOT_IP, wifi_event, NULL, NULL));
+
+    wifi_config_t config = {0};
+    strncpy((char *)config.sta.ssid, CONFIG_APP_WIFI_SSID, sizeof(config.sta.ssid));
+    strncpy((char *)config.sta.password, CONFIG_APP_WIFI_PASSWORD, sizeof(config.sta.password));
+    config.sta.threshold.authmode = strlen(CONFIG_APP_WIFI_PASSWORD) > 0 ? WIFI_AUTH_WPA2_PSK : WIFI_AUTH_OPEN;
+    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
+    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &config));
+    // Modem dorme entre beacons, compativel com o light sleep automatico
+    ESP_ERROR_CHECK(esp_wifi_set_ps(WIFI_PS_MIN_MODEM));
+    ESP_ERROR_CHECK(esp_wifi_start());
+    started = true;
+    return true;
+}
+
+bool wifi_connected(void)
+{
+    return connected;
+}
@@ -0,0 +1,12 @@
+#ifndef MAIN_WIFI_H_
+#define MAIN_WIFI_H_
+
+#include <stdbool.h>
+
+// Conecta como estacao na rede de CONFIG_APP_WIFI_SSID e reconecta
+// sozinho. Retorna false se nenhuma rede estiver configurada. Pode ser
+// chamada por cada servico de rede: so a primeira chamada inicia o Wi-Fi.
+bool wifi_start(void);
+bool wifi_connected(void);
+
+#endif /* MAIN_WIFI_H_ */
@@ -0,0 +1,199 @@
+#include <string.h>
+#include "unity.h"
+#include "ds18b20.h"
+#include "mock_gpio.h"
+#include "mock_onewire.h"
+
+#define TEST_BUS_GPIO 26
+#define TEST_SENSORS_MAX 4
+
+static DeviceAddress roms[TEST_SENSORS_MAX];
+
+// Bus on TEST_BUS_GPIO with sensors 0x10, 0x11... at 12 bits
+static void bus(int sensors, bool parasite)
+{
+    mock_onewire_attach(TEST_BUS_GPIO);
+    for (int i = 0; i < sensors; i++)
+        mock_onewire_add(0x10 + i, parasite, roms[i]);
+    ds18b20_init(TEST_BUS_GPIO);
+    reset_search();
+    if (sensors > 0)
+        ds18b20_setResolution((const DeviceAddress *)roms, sensors, 12);
+}
+
+static float convert_and_read(void)
+{
+    float temp = DEVICE_DISCONNECTED_C;
+    TEST_ASSERT_TRUE(ds18b20_start_conversion());
+    TEST_ASSERT_TRUE(ds18b20_wait_conversion());
+    TEST_ASSERT_TRUE(ds18b20_read_temp(&temp));
+    return temp;
+}
+
+TEST_CASE("reset sees the presence pulse only with a sensor", "[ds18b20]")
+{
+    bus(0, false);
+    TEST_ASSERT_EQUAL_INT(0, ds18b20_reset());
+    float temp;
+    TEST_ASSERT_FALSE(ds18b20_read_temp(&temp));
+    mock_onewire_detach();
+
+    bus(1, false);
+    TEST_ASSERT_EQUAL_INT(1, ds18b20_reset());
+    mock_onewire_detach();
+}
+
+TEST_CASE("power detection tells parasite from powered sensors", "[ds18b20]")
+{
+    bus(1, false);
+    TEST_ASSERT_FALSE(ds18b20_is_parasite());
+    mock_onewire_detach();
+
+    bus(2, true);
+    TEST_ASSERT_TRUE(ds18b20_is_parasite());
+    mock_onewire_detach();
+}
+
+TEST_CASE("powered sensor reads at 12 bits", "[ds18b20]")
+{
+    bus(1, false);
+    mock_onewire_set_temperature(0, 23.5625f);
+    TEST_ASSERT_EQUAL_FLOAT(23.5625f, convert_and_read());
+    mock_onewire_detach();
+}
+
+TEST_CASE("powered conversion ends when the sensor is done", "[ds18b20]")
+{
+    bus(1, false);
+    int64_t start = mock_clock_now();
+    TEST_ASSERT_TRUE(ds18b20_start_conversion());
+    TEST_ASSERT_TRUE(ds18b20_wait_conversion());
+    int64_t elapsed = mock_clock_now() - start;
+    TEST_ASSERT_LESS_THAN(millisToWaitForConversion() * 1000, elapsed);
+    TEST_ASSERT_GREATER_THAN(MOCK_DS18B20_CONVERT_US(12) - 1, elapsed);
+    mock_onewire_detach();
+}
+
+TEST_CASE("parasite conversion keeps the strong pull-up", "[ds18b20]")
+{
+    bus(1, true);
+    mock_onewire_set_temperature(0, 21.0f);
+    TEST_ASSERT_EQUAL_FLOAT(21.0f, convert_and_read());
+    TEST_ASSERT_EQUAL_INT(0, mock_onewire_brownouts(0));
+    // The bus is released once the wait is over
+    TEST_ASSERT_EQUAL_INT(MOCK_PIN_RELEASED, mock_gpio_drive(TEST_BUS_GPIO));
+    mock_onewire_detach();
+}
+
+TEST_CASE("negative temperatures keep their sign", "[ds18b20]")
+{
+    bus(1, false);
+    mock_onewire_set_temperature(0, -10.125f);
+    TEST_ASSERT_EQUAL_FLOAT(-10.125f, convert_and_read());
+    mock_onewire_detach();
+}
+
+TEST_CASE("9 bit resolution masks the undefined bits", "[ds18b20]")
+{
+    bus(1, false);
+    TEST_ASSERT_TRUE(ds18b20_setResolution((const DeviceAddress *)roms, 1, 9));
+    TEST_ASSERT_EQUAL_HEX8(0x1F, mock_onewire_config(0));
+    TEST_ASSERT_EQUAL_INT(94, millisToWaitForConversion());
+    mock_onewire_set_temperature(0, 23.5625f);
+    TEST_ASSERT_EQUAL_FLOAT(23.5f, convert_and_read());
+    mock_onewire_detach();
+}
+
+TEST_CASE("search finds every sensor once", "[ds18b20]")
+{
+    bus(TEST_SENSORS_MAX, false);
+    reset_search();
+    DeviceAddress found[TEST_SENSORS_MAX + 1];
+    int count = 0;
+    while (count <= TEST_SENSORS_MAX && search(found[count], true))
+        count++;
+    TEST_ASSERT_EQUAL_INT(TEST_SENSORS_MAX, count);
+    for (int i = 0; i < count; i++)
+    {
+        TEST_ASSERT_EQUAL_HEX8(found[i][7], ds18b20_crc8(found[i], 7));
+        int matches = 0;
+        for (int j = 0; j < TEST_SENSORS_MAX; j++)
+            matches += memcmp(found[i], roms[j], sizeof(DeviceAddress)) == 0;
+        TEST_ASSERT_EQUAL_INT(1, matches);
+    }
+    mock_onewire_detach();
+}
+
+TEST_CASE("alarm search returns only sensors outside the window", "[ds18b20]")
+{
+    bus(3, false);
+    const float temps[] = {20.0f, 35.0f, 25.0f};
+    for (int i = 0; i < 3; i++)
+    {
+        TEST_ASSERT_TRUE(ds18b20_set_alarm_window((const DeviceAddress *)roms[i], 10, 30));
+        mock_onewire_set_temperature(i, temps[i]);
+    }
+    TEST_ASSERT_TRUE(ds18b20_start_conversion());
+    TEST_ASSERT_TRUE(ds18b20_wait_conversion());
+
+    reset_search();
+    DeviceAddress found;
+    TEST_ASSERT_TRUE(search(found, false));
+    TEST_ASSERT_EQUAL_MEMORY(roms[1], found, sizeof(DeviceAddress));
+    TEST_ASSERT_FALSE(search(found, false));
+    mock_onewire_detach();
+}
+
+TEST_CASE("match ROM reads each sensor of a shared bus", "[ds18b20]")
+{
+    bus(TEST_SENSORS_MAX, false);
+    for (int i = 0; i < TEST_SENSORS_MAX; i++)
+        mock_onewire_set_temperature(i, 10.0f + 2.5f * i);
+    TEST_ASSERT_TRUE(ds18b20_start_conversion());
+    TEST_ASSERT_TRUE(ds18b20_wait_conversion());
+    for (int i = 0; i < TEST_SENSORS_MAX; i++)
+    {
+        float temp = DEVICE_DISCONNECTED_C;
+        TEST_ASSERT_EQUAL_INT(DS18B20_OK, ds18b20_read_temp_rom((const DeviceAddress *)roms[i], &temp));
+        TEST_ASSERT_EQUAL_FLOAT(10.0f + 2.5f * i, temp);
+    }
+    mock_onewire_detach();
+}
+
+TEST_CASE("unknown ROM reads as no device", "[ds18b20]")
+{
+    bus(2, false);
+    DeviceAddress missing = {MOCK_DS18B20_FAMILY, 0x7E};
+    missing[7] = ds18b20_crc8(missing, 7);
+    float temp;
+    TEST_ASSERT_EQUAL_INT(DS18B20_NO_DEVICE, ds18b20_read_temp_rom((const DeviceAddress *)missing, &temp));
+    mock_onewire_detach();
+}
+
+TEST_CASE("corrupted scratchpad fails the CRC", "[ds18b20]")
+{
+    bus(1, false);
+    TEST_ASSERT_TRUE(ds18b20_start_conversion());
+    TEST_ASSERT_TRUE(ds18b20_wait_conversion());
+    mock_onewire_corrupt(0, true);
+    float temp;
+    TEST_ASSERT_EQUAL_INT(DS18B20_CRC_ERROR, ds18b20_read_temp_rom((const DeviceAddress *)roms[0], &temp));
+    mock_onewire_corrupt(0, false);
+    TEST_ASSERT_EQUAL_INT(DS18B20_OK, ds18b20_read_temp_rom((const DeviceAddress *)roms[0], &temp));
+    mock_onewire_detach();
+}
+
+TEST_CASE("bus counters count resets and slots", "[ds18b20]")
+{
+    bus(1, false);
+    ds18b20_stats_t before;
+    ds18b20_stats_t after;
+    ds18b20_get_stats(&before);
+    float temp;
+    TEST_ASSERT_TRUE(ds18b20_read_temp(&temp));
+    ds18b20_get_stats(&after);
+    // Reset, SKIP ROM, READ SCRATCHPAD, 9 bytes, reset
+    TEST_ASSERT_EQUAL_UINT32(2, after.resets - before.resets);
+    TEST_ASSERT_EQUAL_UINT32(8 + 8 + 9 * 8, after.slots - before.slots);
+    mock_onewire_detach();
+}
@@ -0,0 +1,198 @@
+#include <stdio.h>
+#include <string.h>
+#include "unity.h"
+#include "ssd1306.h"
+#include "font8x8_basic.h"
+#include "mock_display.h"
+
+#define TEST_SDA_GPIO 21
+#define TEST_SCL_GPIO 22
+#define TEST_MOSI_GPIO 23
+#define TEST_SCLK_GPIO 18
+#define TEST_CS_GPIO 5
+#define TEST_DC_GPIO 27
+
+static SSD1306_t dev;
+
+static void i2c_panel(int height, bool flip)
+{
+    mock_display_reset();
+    memset(&dev, 0, sizeof(dev));
+    i2c_master_init(&dev, TEST_SDA_GPIO, TEST_SCL_GPIO, -1);
+    dev._flip = flip;
+    ssd1306_init(&dev, 128, height);
+}
+
+static void spi_panel(int height)
+{
+    mock_display_reset();
+    memset(&dev, 0, sizeof(dev));
+    spi_master_init(&dev, TEST_MOSI_GPIO, TEST_SCLK_GPIO, TEST_CS_GPIO, TEST_DC_GPIO, -1);
+    mock_display_set_dc(TEST_DC_GPIO);
+    ssd1306_init(&dev, 128, height);
+}
+
+// 8x8 glyphs of text from the left edge, the rest of the page blank
+static void render(uint8_t *segs, const char *text)
+{
+    memset(segs, 0, 128);
+    for (size_t i = 0; i < strlen(text) && i < 16; i++)
+        memcpy(&segs[i * 8], font8x8_basic_tr[(uint8_t)text[i]], 8);
+}
+
+TEST_CASE("init turns the panel on with the configured mux ratio", "[ssd1306]")
+{
+    i2c_panel(64, false);
+    const mock_panel_t *panel = mock_display_panel();
+    TEST_ASSERT_TRUE(panel->on);
+    TEST_ASSERT_EQUAL_INT(63, panel->muxRatio);
+    TEST_ASSERT_EQUAL_INT(0xFF, panel->contrast);
+    TEST_ASSERT_FALSE(panel->scrolling);
+    TEST_ASSERT_EQUAL_UINT32(0, panel->nacks);
+
+    i2c_panel(32, false);
+    TEST_ASSERT_EQUAL_INT(31, mock_display_panel()->muxRatio);
+    TEST_ASSERT_EQUAL_INT(4, ssd1306_get_pages(&dev));
+}
+
+TEST_CASE("show_buffer writes every page of GDDRAM", "[ssd1306]")
+{
+    i2c_panel(64, false);
+    for (int page = 0; page < dev._pages; page++)
+    {
+        for (int seg = 0; seg < 128; seg++)
+            dev._page[page]._segs[seg] = page * 31 + seg;
+    }
+    ssd1306_show_buffer(&dev);
+    for (int page = 0; page < dev._pages; page++)
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(dev._page[page]._segs, mock_display_panel()->ram[page], 128);
+}
+
+TEST_CASE("text lands on its page and nowhere else", "[ssd1306]")
+{
+    i2c_panel(64, false);
+    ssd1306_clear_screen(&dev, false);
+    ssd1306_display_text(&dev, 2, "Nivel 42%", 9, false);
+
+    uint8_t expected[128];
+    uint8_t blank[128] = {0};
+    render(expected, "Nivel 42%");
+    const mock_panel_t *panel = mock_display_panel();
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, panel->ram[2], 128);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(blank, panel->ram[1], 128);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(blank, panel->ram[3], 128);
+}
+
+TEST_CASE("text_at redraws only its columns", "[ssd1306]")
+{
+    i2c_panel(64, false);
+    ssd1306_display_text(&dev, 0, "Temp  25.0 C", 12, false);
+    const mock_panel_t *panel = mock_display_panel();
+    uint32_t before = panel->transactions;
+    ssd1306_display_text_at(&dev, 0, 6, "26.5", 4, false);
+
+    uint8_t expected[128];
+    render(expected, "Temp  26.5 C");
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, panel->ram[0], 128);
+    // Column and page commands, then one data transfer
+    TEST_ASSERT_EQUAL_UINT32(2, panel->transactions - before);
+}
+
+TEST_CASE("flip maps screen pages to the opposite GDDRAM page", "[ssd1306]")
+{
+    i2c_panel(64, true);
+    ssd1306_display_text(&dev, 0, "A", 1, false);
+    uint8_t glyph[8];
+    memcpy(glyph, font8x8_basic_tr['A'], 8);
+    ssd1306_flip(glyph, 8);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(glyph, mock_display_panel()->ram[7], 8);
+}
+
+TEST_CASE("ticker shows the newest line at the bottom", "[ssd1306]")
+{
+    i2c_panel(64, false);
+    ssd1306_ticker_init(&dev);
+    char text[8];
+    for (int i = 0; i < 11; i++)
+    {
+        int len = snprintf(text, sizeof(text), "L%d", i);
+        ssd1306_ticker_text(&dev, text, len, false);
+    }
+
+    // Lines scroll up: screen line 7 holds L10, line 6 holds L9 and so on
+    uint8_t expected[128];
+    const mock_panel_t *panel = mock_display_panel();
+    for (int line = 0; line < 8; line++)
+    {
+        snprintf(text, sizeof(text), "L%d", 3 + line);
+        render(expected, text);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, panel->ram[mock_display_ram_page(line)], 128);
+    }
+}
+
+TEST_CASE("a ticker line costs one page and one start line command", "[ssd1306]")
+{
+    i2c_panel(64, false);
+    ssd1306_ticker_init(&dev);
+    const mock_panel_t *panel = mock_display_panel();
+    uint32_t transactions = panel->transactions;
+    uint32_t bytes = panel->bytes;
+    ssd1306_ticker_text(&dev, "evento", 6, false);
+    TEST_ASSERT_EQUAL_UINT32(3, panel->transactions - transactions);
+    TEST_ASSERT_EQUAL_UINT32(5 + (2 + 128) + 3, panel->bytes - bytes);
+}
+
+TEST_CASE("contrast and power commands reach the panel", "[ssd1306]")
+{
+    i2c_panel(64, false);
+    ssd1306_contrast(&dev, 0x20);
+    TEST_ASSERT_EQUAL_INT(0x20, mock_display_panel()->contrast);
+    ssd1306_display_power(&dev, false);
+    TEST_ASSERT_FALSE(mock_display_panel()->on);
+    ssd1306_display_power(&dev, true);
+    TEST_ASSERT_TRUE(mock_display_panel()->on);
+    ssd1306_hardware_scroll(&dev, SCROLL_RIGHT);
+    TEST_ASSERT_TRUE(mock_display_panel()->scrolling);
+    ssd1306_hardware_scroll(&dev, SCROLL_STOP);
+    TEST_ASSERT_FALSE(mock_display_panel()->scrolling);
+}
+
+TEST_CASE("bus counters match the I2C wire", "[ssd1306]")
+{
+    ssd1306_stats_t before;
+    ssd1306_stats_t after;
+    ssd1306_get_stats(&before);
+    i2c_panel(64, false);
+    ssd1306_clear_screen(&dev, false);
+    ssd1306_display_text(&dev, 1, "abc", 3, true);
+    ssd1306_contrast(&dev, 0x80);
+    ssd1306_display_power(&dev, false);
+    ssd1306_hardware_scroll(&dev, SCROLL_UP);
+    ssd1306_hardware_scroll(&dev, SCROLL_LEFT);
+    ssd1306_hardware_scroll(&dev, SCROLL_STOP);
+    ssd1306_ticker_init(&dev);
+    ssd1306_ticker_text(&dev, "x", 1, false);
+    ssd1306_get_stats(&after);
+
+    const mock_panel_t *panel = mock_display_panel();
+    TEST_ASSERT_EQUAL_UINT32(panel->transactions, after.transactions - before.transactions);
+    TEST_ASSERT_EQUAL_UINT32(panel->bytes, after.bytes - before.bytes);
+}
+
+TEST_CASE("SPI transport splits commands and data on D/C", "[ssd1306]")
+{
+    ssd1306_stats_t before;
+    ssd1306_stats_t after;
+    ssd1306_get_stats(&before);
+    spi_panel(64);
+    TEST_ASSERT_TRUE(mock_display_panel()->on);
+    ssd1306_display_text(&dev, 5, "SPI", 3, false);
+    ssd1306_get_stats(&after);
+
+    uint8_t expected[128];
+    render(expected, "SPI");
+    const mock_panel_t *panel = mock_display_panel();
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, panel->ram[5], 128);
+    TEST_ASSERT_EQUAL_UINT32(panel->transactions, after.transactions - before.transactions);
+    TEST_ASSERT_EQUAL_UINT32(panel->bytes, after.bytes - before.bytes);
+}
@@ -0,0 +1,132 @@
+// Bus cost of the SSD1306 operations the firmware uses, on both
+// transports, as CSV on stdout:
+//
+//   transport,case,transactions,bytes,bus_us
+//
+// transactions and bytes are what the mocked bus saw; bus_us is the time
+// they take on the wire: 9 clocks per I2C byte (8 bits and the ACK) plus
+// start and stop at 400 kHz, 8 clocks per byte at 1 MHz on SPI. Exits with
+// 1 if the component's own counters disagree with the wire.
+#include <stdio.h>
+#include <string.h>
+#include "ssd1306.h"
+#include "mock_display.h"
+
+#define BENCH_SDA_GPIO 21
+#define BENCH_SCL_GPIO 22
+#define BENCH_MOSI_GPIO 23
+#define BENCH_SCLK_GPIO 18
+#define BENCH_CS_GPIO 5
+#define BENCH_DC_GPIO 27
+
+#define I2C_CLOCK_US 2.5
+#define SPI_CLOCK_US 1.0
+
+typedef enum
+{
+    BENCH_I2C,
+    BENCH_SPI,
+} bench_transport_t;
+
+static SSD1306_t dev;
+static bench_transport_t transport;
+static uint32_t transactionsBefore;
+static uint32_t bytesBefore;
+static int mismatches;
+
+static void begin(void)
+{
+    const mock_panel_t *panel = mock_display_panel();
+    transactionsBefore = panel->transactions;
+    bytesBefore = panel->bytes;
+}
+
+static void end(const char *name)
+{
+    const mock_panel_t *panel = mock_display_panel();
+    uint32_t transactions = panel->transactions - transactionsBefore;
+    uint32_t bytes = panel->bytes - bytesBefore;
+    double busUs = transport == BENCH_I2C ? (9.0 * bytes + 2.0 * transactions) * I2C_CLOCK_US
+                                          : 8.0 * bytes * SPI_CLOCK_US;
+    printf("%s,%s,%u,%u,%.1f\n", transport == BENCH_I2C ? "i2c" : "spi", name, (unsigned)transactions,
+           (unsigned)bytes, busUs);
+}
+
+static void panel_init(void)
+{
+    mock_display_reset();
+    memset(&dev, 0, sizeof(dev));
+    if (transport == BENCH_I2C)
+    {
+        i2c_master_init(&dev, BENCH_SDA_GPIO, BENCH_SCL_GPIO, -1);
+    }
+    else
+    {
+        spi_master_init(&dev, BENCH_MOSI_GPIO, BENCH_SCLK_GPIO, BENCH_CS_GPIO, BENCH_DC_GPIO, -1);
+        mock_display_set_dc(BENCH_DC_GPIO);
+    }
+    begin();
+    ssd1306_init(&dev, 128, 64);
+    end("init");
+}
+
+static void run(bench_transport_t which)
+{
+    transport = which;
+    ssd1306_stats_t before;
+    ssd1306_stats_t after;
+    ssd1306_get_stats(&before);
+
+    panel_init();
+
+    begin();
+    ssd1306_clear_screen(&dev, false);
+    end("clear");
+
+    for (int page = 0; page < dev._pages; page++)
+        memset(dev._page[page]._segs, 0x55 << (page & 1), sizeof(dev._page[page]._segs));
+    begin();
+    ssd1306_show_buffer(&dev);
+    end("show_buffer");
+
+    begin();
+    ssd1306_display_text(&dev, 2, "Nivel  42.5 %", 13, false);
+    end("text_line");
+
+    begin();
+    ssd1306_display_text_at(&dev, 2, 7, "43.0", 4, false);
+    end("text_at");
+
+    begin();
+    ssd1306_contrast(&dev, 0x40);
+    end("contrast");
+
+    ssd1306_ticker_init(&dev);
+    begin();
+    ssd1306_ticker_text(&dev, "C1 +vazamento", 13, false);
+    end("ticker_line");
+
+    begin();
+    ssd1306_display_power(&dev, false);
+    ssd1306_display_power(&dev, true);
+    end("power");
+
+    ssd1306_get_stats(&after);
+    const mock_panel_t *panel = mock_display_panel();
+    if (after.transactions - before.transactions != panel->transactions ||
+        after.bytes - before.bytes != panel->bytes)
+    {
+        fprintf(stderr, "%s: driver counted %u transactions, %u bytes; wire %u, %u\n",
+                which == BENCH_I2C ? "i2c" : "spi", (unsigned)(after.transactions - before.transactions),
+                (unsigned)(after.bytes - before.bytes), (unsigned)panel->transactions, (unsigned)panel->bytes);
+        mismatches++;
+    }
+}
+
+int main(void)
+{
+    printf("transport,case,transactions,bytes,bus_us\n");
+    run(BENCH_I2C);
+    run(BENCH_SPI);
+    return mismatches == 0 ? 0 : 1;
+}
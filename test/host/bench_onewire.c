@@ -0,0 +1,125 @@
+// Bus cost of the DS18B20 operations the firmware uses, on simulated
+// sensors, as CSV on stdout:
+//
+//   case,sensors,resets,slots,bus_us
+//
+// resets and slots come from ds18b20_get_stats; bus_us is the time the
+// operation held the caller on the virtual clock, conversion waits
+// included.
+#include <stdio.h>
+#include "ds18b20.h"
+#include "mock_gpio.h"
+#include "mock_onewire.h"
+
+#define BENCH_BUS_GPIO 26
+#define BENCH_SENSORS 4
+
+static DeviceAddress roms[BENCH_SENSORS];
+static ds18b20_stats_t statsBefore;
+static int64_t clockBefore;
+static int failures;
+
+static void bus(int sensors, bool parasite)
+{
+    mock_onewire_attach(BENCH_BUS_GPIO);
+    for (int i = 0; i < sensors; i++)
+    {
+        mock_onewire_add(0x10 + i, parasite, roms[i]);
+        mock_onewire_set_temperature(i, 20.0f + i);
+    }
+    ds18b20_init(BENCH_BUS_GPIO);
+    reset_search();
+    ds18b20_setResolution((const DeviceAddress *)roms, sensors, 12);
+}
+
+static void begin(void)
+{
+    ds18b20_get_stats(&statsBefore);
+    clockBefore = mock_clock_now();
+}
+
+static void end(const char *name, int sensors, bool ok)
+{
+    ds18b20_stats_t stats;
+    ds18b20_get_stats(&stats);
+    printf("%s,%d,%u,%u,%lld\n", name, sensors, (unsigned)(stats.resets - statsBefore.resets),
+           (unsigned)(stats.slots - statsBefore.slots), (long long)(mock_clock_now() - clockBefore));
+    if (!ok)
+    {
+        fprintf(stderr, "%s failed\n", name);
+        failures++;
+    }
+}
+
+static bool convert(void)
+{
+    return ds18b20_start_conversion() && ds18b20_wait_conversion();
+}
+
+int main(void)
+{
+    printf("case,sensors,resets,slots,bus_us\n");
+
+    bus(1, false);
+    begin();
+    bool ok = ds18b20_reset() == 1;
+    end("presence", 1, ok);
+
+    begin();
+    ok = ds18b20_detect_power() && !ds18b20_is_parasite();
+    end("detect_power", 1, ok);
+
+    begin();
+    ok = convert();
+    end("convert_powered_12bit", 1, ok);
+
+    float temp;
+    begin();
+    ok = ds18b20_read_temp(&temp) && temp == 20.0f;
+    end("read_skip_rom", 1, ok);
+
+    begin();
+    ok = ds18b20_setResolution((const DeviceAddress *)roms, 1, 9);
+    end("set_resolution", 1, ok);
+
+    begin();
+    ok = convert();
+    end("convert_powered_9bit", 1, ok);
+    mock_onewire_detach();
+
+    bus(1, true);
+    begin();
+    ok = convert() && mock_onewire_brownouts(0) == 0;
+    end("convert_parasite_12bit", 1, ok);
+    mock_onewire_detach();
+
+    bus(BENCH_SENSORS, false);
+    convert();
+    begin();
+    ok = true;
+    for (int i = 0; i < BENCH_SENSORS; i++)
+        ok = ok && ds18b20_read_temp_rom((const DeviceAddress *)roms[i], &temp) == DS18B20_OK && temp == 20.0f + i;
+    end("read_match_rom", BENCH_SENSORS, ok);
+
+    DeviceAddress found;
+    int count = 0;
+    reset_search();
+    begin();
+    while (count <= BENCH_SENSORS && search(found, true))
+        count++;
+    end("search", BENCH_SENSORS, count == BENCH_SENSORS);
+
+    // Only the last sensor is outside the window
+    for (int i = 0; i < BENCH_SENSORS; i++)
+        ds18b20_set_alarm_window((const DeviceAddress *)roms[i], 10, 20 + BENCH_SENSORS - 1);
+    convert();
+    count = 0;
+    reset_search();
+    begin();
+    while (count <= BENCH_SENSORS && search(found, false))
+        count++;
+    end("alarm_search", BENCH_SENSORS, count == 1);
+    mock_onewire_detach();
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,277 @@
+// Round trip of the Modbus RTU slave core (main/modbus.c) over a pseudo
+// terminal.
+//
+// The test is the master on the pty master side; a thread reads the slave
+// side the way main/modbus_uart.c reads UART2: bytes accumulate until the
+// line goes quiet, then the frame goes to modbus_handle and the reply is
+// written back. A pty has no baud rate, so the 3.5 character silence is a
+// fixed MODBUS_SILENCE_MS.
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "modbus.h"
+
+#define SLAVE_ADDRESS 1
+#define MODBUS_SILENCE_MS 5
+// The master gives up on a reply after this long; also how long a test
+// waits to be sure no reply comes
+#define REPLY_TIMEOUT_MS 200
+#define REJECTED_VALUE 0xFFFF
+
+static modbus_image_t image;
+static int failures;
+
+#define CHECK(cond, name)                                          \
+    do                                                             \
+    {                                                              \
+        if (cond)                                                  \
+            printf("ok   %s\n", name);                             \
+        else                                                       \
+        {                                                          \
+            printf("FAIL %s (%s:%d)\n", name, __FILE__, __LINE__); \
+            failures++;                                            \
+        }                                                          \
+    } while (0)
+
+// Same contract as apply_holding in main/modbus_uart.c: all or nothing
+static bool apply_holding(uint16_t reg, const uint16_t *values, uint16_t count)
+{
+    for (uint16_t i = 0; i < count; i++)
+    {
+        if (values[i] == REJECTED_VALUE)
+            return false;
+    }
+    memcpy(&image.holding[reg], values, count * sizeof(values[0]));
+    return true;
+}
+
+static modbus_slave_t slave = {
+    .address = SLAVE_ADDRESS,
+    .image = &image,
+    .write = apply_holding,
+};
+
+static void *slave_thread(void *arg)
+{
+    int fd = *(int *)arg;
+    uint8_t frame[MODBUS_FRAME_MAX];
+    uint8_t resp[MODBUS_FRAME_MAX];
+    size_t len = 0;
+    bool discard = false;
+
+    for (;;)
+    {
+        struct pollfd p = {.fd = fd, .events = POLLIN};
+        int ready = poll(&p, 1, len > 0 || discard ? MODBUS_SILENCE_MS : -1);
+        if (ready < 0 && errno == EINTR)
+            continue;
+        if (ready < 0)
+            break;
+        if (ready == 0)
+        {
+            size_t respLen = discard ? 0 : modbus_handle(&slave, frame, len, resp);
+            if (respLen > 0 && write(fd, resp, respLen) != (ssize_t)respLen)
+                break;
+            len = 0;
+            discard = false;
+            continue;
+        }
+
+        uint8_t chunk[64];
+        ssize_t n = read(fd, chunk, sizeof(chunk));
+        // EIO once the master side is closed
+        if (n <= 0)
+            break;
+        if (len + n > sizeof(frame))
+            discard = true;
+        else
+        {
+            memcpy(&frame[len], chunk, n);
+            len += n;
+        }
+    }
+    return NULL;
+}
+
+static size_t frame_build(uint8_t *frame, uint8_t address, const uint8_t *pdu, size_t pduLen)
+{
+    frame[0] = address;
+    memcpy(&frame[1], pdu, pduLen);
+    uint16_t crc = modbus_crc16(frame, pduLen + 1);
+    frame[pduLen + 1] = crc & 0xFF;
+    frame[pduLen + 2] = crc >> 8;
+    return pduLen + 3;
+}
+
+// Sends a request and collects the reply until the line goes quiet.
+// Returns the reply length, 0 if nothing came back.
+static size_t transact(int master, const uint8_t *req, size_t len, uint8_t *resp, size_t size)
+{
+    if (write(master, req, len) != (ssize_t)len)
+    {
+        perror("write");
+        exit(2);
+    }
+    size_t got = 0;
+    int timeout = REPLY_TIMEOUT_MS;
+    for (;;)
+    {
+        struct pollfd p = {.fd = master, .events = POLLIN};
+        if (poll(&p, 1, timeout) <= 0)
+            break;
+        ssize_t n = read(master, &resp[got], size - got);
+        if (n <= 0)
+            break;
+        got += n;
+        if (got == size)
+            break;
+        // Inside a reply the gap between chunks is far below the silence
+        timeout = 4 * MODBUS_SILENCE_MS;
+    }
+    return got;
+}
+
+// Request pdu from the master, expected pdu from the slave (NULL: no reply)
+static void round_trip(int master, const char *name, uint8_t address, const uint8_t *pdu, size_t pduLen,
+                       const uint8_t *expected, size_t expectedLen)
+{
+    uint8_t req[MODBUS_FRAME_MAX + 3];
+    uint8_t want[MODBUS_FRAME_MAX + 3];
+    uint8_t resp[MODBUS_FRAME_MAX + 3];
+    size_t reqLen = frame_build(req, address, pdu, pduLen);
+    size_t got = transact(master, req, reqLen, resp, sizeof(resp));
+    if (expected == NULL)
+    {
+        CHECK(got == 0, name);
+        return;
+    }
+    size_t wantLen = frame_build(want, SLAVE_ADDRESS, expected, expectedLen);
+    CHECK(got == wantLen && memcmp(resp, want, wantLen) == 0, name);
+}
+
+static void raw_request(int master, const char *name, const uint8_t *req, size_t len)
+{
+    uint8_t resp[MODBUS_FRAME_MAX + 3];
+    CHECK(transact(master, req, len, resp, sizeof(resp)) == 0, name);
+}
+
+int main(void)
+{
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0)
+    {
+        perror("posix_openpt");
+        return 2;
+    }
+    int fd = open(ptsname(master), O_RDWR | O_NOCTTY);
+    if (fd < 0)
+    {
+        perror("open pty");
+        return 2;
+    }
+    // Raw before the first byte: no echo, no line editing, no CR/LF mapping
+    struct termios tio;
+    tcgetattr(fd, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(fd, TCSANOW, &tio);
+
+    for (int i = 0; i < 20; i++)
+        image.input[i] = 0x1000 + i;
+    image.inputCount = 20;
+    image.holding[0] = 100;
+    image.holding[1] = 4000;
+    image.holdingCount = 4;
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, slave_thread, &fd);
+
+    // Reference frame from the Modbus specification examples
+    const uint8_t known[] = {0x01, 0x04, 0x00, 0x00, 0x00, 0x01};
+    CHECK(modbus_crc16(known, sizeof(known)) == 0xCA31, "crc16 reference");
+
+    round_trip(master, "read input registers", SLAVE_ADDRESS,
+               (const uint8_t[]){0x04, 0x00, 0x02, 0x00, 0x03}, 5,
+               (const uint8_t[]){0x04, 0x06, 0x10, 0x02, 0x10, 0x03, 0x10, 0x04}, 8);
+    round_trip(master, "read holding registers", SLAVE_ADDRESS,
+               (const uint8_t[]){0x03, 0x00, 0x00, 0x00, 0x02}, 5,
+               (const uint8_t[]){0x03, 0x04, 0x00, 0x64, 0x0F, 0xA0}, 6);
+    round_trip(master, "write single register", SLAVE_ADDRESS,
+               (const uint8_t[]){0x06, 0x00, 0x01, 0x12, 0x34}, 5,
+               (const uint8_t[]){0x06, 0x00, 0x01, 0x12, 0x34}, 5);
+    round_trip(master, "write multiple registers", SLAVE_ADDRESS,
+               (const uint8_t[]){0x10, 0x00, 0x02, 0x00, 0x02, 0x04, 0x00, 0x07, 0x00, 0x08}, 10,
+               (const uint8_t[]){0x10, 0x00, 0x02, 0x00, 0x02}, 5);
+    round_trip(master, "written values read back", SLAVE_ADDRESS,
+               (const uint8_t[]){0x03, 0x00, 0x01, 0x00, 0x03}, 5,
+               (const uint8_t[]){0x03, 0x06, 0x12, 0x34, 0x00, 0x07, 0x00, 0x08}, 8);
+
+    round_trip(master, "rejected write is an illegal value", SLAVE_ADDRESS,
+               (const uint8_t[]){0x10, 0x00, 0x00, 0x00, 0x02, 0x04, 0x00, 0x01, 0xFF, 0xFF}, 10,
+               (const uint8_t[]){0x90, MODBUS_ILLEGAL_VALUE}, 2);
+    round_trip(master, "rejected write applies nothing", SLAVE_ADDRESS,
+               (const uint8_t[]){0x03, 0x00, 0x00, 0x00, 0x01}, 5,
+               (const uint8_t[]){0x03, 0x02, 0x00, 0x64}, 4);
+    round_trip(master, "read past the image", SLAVE_ADDRESS,
+               (const uint8_t[]){0x04, 0x00, 0x13, 0x00, 0x02}, 5,
+               (const uint8_t[]){0x84, MODBUS_ILLEGAL_ADDRESS}, 2);
+    round_trip(master, "write past the image", SLAVE_ADDRESS,
+               (const uint8_t[]){0x06, 0x00, 0x04, 0x00, 0x01}, 5,
+               (const uint8_t[]){0x86, MODBUS_ILLEGAL_ADDRESS}, 2);
+    round_trip(master, "zero register read", SLAVE_ADDRESS,
+               (const uint8_t[]){0x03, 0x00, 0x00, 0x00, 0x00}, 5,
+               (const uint8_t[]){0x83, MODBUS_ILLEGAL_VALUE}, 2);
+    round_trip(master, "byte count mismatch", SLAVE_ADDRESS,
+               (const uint8_t[]){0x10, 0x00, 0x00, 0x00, 0x01, 0x04, 0x00, 0x01}, 8,
+               (const uint8_t[]){0x90, MODBUS_ILLEGAL_VALUE}, 2);
+    round_trip(master, "unknown function", SLAVE_ADDRESS,
+               (const uint8_t[]){0x2B, 0x0E, 0x01, 0x00}, 4,
+               (const uint8_t[]){0xAB, MODBUS_ILLEGAL_FUNCTION}, 2);
+
+    round_trip(master, "other slave is ignored", SLAVE_ADDRESS + 1,
+               (const uint8_t[]){0x03, 0x00, 0x00, 0x00, 0x01}, 5, NULL, 0);
+    round_trip(master, "broadcast write is silent", 0,
+               (const uint8_t[]){0x06, 0x00, 0x00, 0x00, 0x37}, 5, NULL, 0);
+    round_trip(master, "broadcast write is applied", SLAVE_ADDRESS,
+               (const uint8_t[]){0x03, 0x00, 0x00, 0x00, 0x01}, 5,
+               (const uint8_t[]){0x03, 0x02, 0x00, 0x37}, 4);
+
+    uint8_t bad[8];
+    frame_build(bad, SLAVE_ADDRESS, (const uint8_t[]){0x03, 0x00, 0x00, 0x00, 0x01}, 5);
+    bad[7] ^= 0x01;
+    raw_request(master, "bad crc is ignored", bad, sizeof(bad));
+    raw_request(master, "short frame is ignored", (const uint8_t[]){SLAVE_ADDRESS, 0x03, 0x00}, 3);
+    uint8_t huge[MODBUS_FRAME_MAX + 40];
+    memset(huge, 0x55, sizeof(huge));
+    huge[0] = SLAVE_ADDRESS;
+    raw_request(master, "oversized frame is dropped", huge, sizeof(huge));
+    round_trip(master, "slave recovers after the oversized frame", SLAVE_ADDRESS,
+               (const uint8_t[]){0x04, 0x00, 0x00, 0x00, 0x01}, 5,
+               (const uint8_t[]){0x04, 0x02, 0x10, 0x00}, 4);
+
+    uint8_t bulk[] = {0x04, 0x00, 0x00, 0x00, 20};
+    uint8_t bulkResp[2 + 40];
+    bulkResp[0] = 0x04;
+    bulkResp[1] = 40;
+    for (int i = 0; i < 20; i++)
+    {
+        bulkResp[2 + 2 * i] = (0x1000 + i) >> 8;
+        bulkResp[3 + 2 * i] = (0x1000 + i) & 0xFF;
+    }
+    round_trip(master, "read the whole input image", SLAVE_ADDRESS, bulk, sizeof(bulk), bulkResp, sizeof(bulkResp));
+
+    close(master);
+    pthread_join(thread, NULL);
+    close(fd);
+
+    printf("%d failure(s)\n", failures);
+    return failures == 0 ? 0 : 1;
+}
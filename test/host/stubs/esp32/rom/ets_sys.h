@@ -0,0 +1,6 @@
+#pragma once
+
+#include <stdint.h>
+
+// Advances the mock clock (test/mocks/mock_gpio.c)
+void ets_delay_us(uint32_t us);
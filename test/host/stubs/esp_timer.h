@@ -0,0 +1,6 @@
+#pragma once
+
+#include <stdint.h>
+
+// Mock clock (test/mocks/mock_gpio.c)
+int64_t esp_timer_get_time(void);
@@ -0,0 +1,6 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+// Advances the mock clock (test/mocks/mock_gpio.c)
+void vTaskDelay(const TickType_t ticks);
@@ -0,0 +1,11 @@
+// Host build: the options the components under test read, as in the
+// project sdkconfig
+#pragma once
+
+#define CONFIG_I2C_INTERFACE 1
+#define CONFIG_SSD1306_128x64 1
+#define CONFIG_OFFSETX 0
+#define CONFIG_SDA_GPIO 21
+#define CONFIG_SCL_GPIO 22
+#define CONFIG_RESET_GPIO -1
+#define CONFIG_SPI2_HOST 1
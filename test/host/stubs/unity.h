@@ -0,0 +1,57 @@
+// Host build: the subset of Unity and of the ESP-IDF test runner used by
+// test/app/main, so the same TEST_CASEs run under ctest. A failed
+// assertion ends the current case; unity_host.c runs all of them.
+#pragma once
+
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+typedef void (*unity_case_fn_t)(void);
+
+void unity_register(const char *name, const char *tags, unity_case_fn_t fn, const char *file);
+void unity_fail(const char *file, int line, const char *message);
+void unity_run_all_tests(void);
+void UNITY_BEGIN(void);
+int UNITY_END(void);
+
+#define UNITY_CASE_CAT_(a, b) a##b
+#define UNITY_CASE_CAT(a, b) UNITY_CASE_CAT_(a, b)
+#define UNITY_CASE_FN UNITY_CASE_CAT(unity_case_, __LINE__)
+#define UNITY_CASE_REG UNITY_CASE_CAT(unity_register_, __LINE__)
+
+#define TEST_CASE(name, tags)                                               \
+    static void UNITY_CASE_FN(void);                                        \
+    __attribute__((constructor)) static void UNITY_CASE_REG(void)           \
+    {                                                                       \
+        unity_register(name, tags, UNITY_CASE_FN, __FILE__);                \
+    }                                                                       \
+    static void UNITY_CASE_FN(void)
+
+#define UNITY_CHECK(cond, message)                     \
+    do                                                 \
+    {                                                  \
+        if (!(cond))                                   \
+            unity_fail(__FILE__, __LINE__, message);   \
+    } while (0)
+
+#define TEST_ASSERT(cond) UNITY_CHECK((cond), #cond)
+#define TEST_ASSERT_TRUE(cond) UNITY_CHECK((cond), #cond " is false")
+#define TEST_ASSERT_FALSE(cond) UNITY_CHECK(!(cond), #cond " is true")
+#define TEST_ASSERT_NULL(p) UNITY_CHECK((p) == NULL, #p " is not NULL")
+#define TEST_ASSERT_EQUAL(expected, actual) UNITY_CHECK((expected) == (actual), #actual " != " #expected)
+#define TEST_ASSERT_EQUAL_INT(expected, actual) TEST_ASSERT_EQUAL((int)(expected), (int)(actual))
+#define TEST_ASSERT_EQUAL_UINT32(expected, actual) TEST_ASSERT_EQUAL((uint32_t)(expected), (uint32_t)(actual))
+#define TEST_ASSERT_EQUAL_HEX8(expected, actual) TEST_ASSERT_EQUAL((uint8_t)(expected), (uint8_t)(actual))
+#define TEST_ASSERT_NOT_EQUAL(expected, actual) UNITY_CHECK((expected) != (actual), #actual " == " #expected)
+#define TEST_ASSERT_LESS_THAN(threshold, actual) UNITY_CHECK((actual) < (threshold), #actual " >= " #threshold)
+#define TEST_ASSERT_GREATER_THAN(threshold, actual) UNITY_CHECK((actual) > (threshold), #actual " <= " #threshold)
+#define TEST_ASSERT_FLOAT_WITHIN(delta, expected, actual) \
+    UNITY_CHECK(fabs((double)(actual) - (double)(expected)) <= (delta), #actual " not within " #delta " of " #expected)
+#define TEST_ASSERT_EQUAL_FLOAT(expected, actual) \
+    TEST_ASSERT_FLOAT_WITHIN(1e-5 * fabs((double)(expected)) + 1e-9, expected, actual)
+#define TEST_ASSERT_EQUAL_MEMORY(expected, actual, len) \
+    UNITY_CHECK(memcmp((expected), (actual), (len)) == 0, #actual " differs from " #expected)
+#define TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, actual, count) TEST_ASSERT_EQUAL_MEMORY(expected, actual, count)
@@ -0,0 +1,81 @@
+// Runner for the Unity shim in stubs/unity.h. main() calls app_main() of
+// test/app/main/test_main.c, like the ESP-IDF startup does on the target.
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "unity.h"
+
+#define UNITY_CASES_MAX 64
+
+typedef struct
+{
+    const char *name;
+    const char *tags;
+    unity_case_fn_t fn;
+    const char *file;
+} unity_case_t;
+
+static unity_case_t cases[UNITY_CASES_MAX];
+static int caseCount;
+static int failed;
+static int run;
+static jmp_buf abortCase;
+
+void app_main(void);
+
+void unity_register(const char *name, const char *tags, unity_case_fn_t fn, const char *file)
+{
+    if (caseCount == UNITY_CASES_MAX)
+    {
+        fprintf(stderr, "too many test cases, raise UNITY_CASES_MAX\n");
+        abort();
+    }
+    cases[caseCount++] = (unity_case_t){name, tags, fn, file};
+}
+
+void unity_fail(const char *file, int line, const char *message)
+{
+    printf("%s:%d: %s\n", file, line, message);
+    longjmp(abortCase, 1);
+}
+
+void UNITY_BEGIN(void)
+{
+    failed = 0;
+    run = 0;
+}
+
+// A failed assertion jumps back here and the case counts as failed
+static void run_case(const unity_case_t *test)
+{
+    run++;
+    if (setjmp(abortCase) == 0)
+    {
+        test->fn();
+        printf("PASS %s %s\n", test->tags, test->name);
+    }
+    else
+    {
+        printf("FAIL %s %s\n", test->tags, test->name);
+        failed++;
+    }
+}
+
+void unity_run_all_tests(void)
+{
+    for (int i = 0; i < caseCount; i++)
+        run_case(&cases[i]);
+}
+
+int UNITY_END(void)
+{
+    printf("%d Tests %d Failures\n", run, failed);
+    return failed;
+}
+
+int main(void)
+{
+    app_main();
+    return failed == 0 ? 0 : 1;
+}
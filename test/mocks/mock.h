@@ -0,0 +1,16 @@
+#ifndef TEST_MOCK_H_
+#define TEST_MOCK_H_
+
+// Mocks of the ESP-IDF driver calls made by the components under test.
+// On the host a mock is the only definition of the call. In the target
+// test app the real driver stays linked and the components' calls are
+// redirected with -Wl,--wrap=<name> (MOCK_WRAP=1), so a mock can hand
+// calls it does not model to __real_<name>.
+#if MOCK_WRAP
+#define MOCK(name) __wrap_##name
+#define REAL(name) __real_##name
+#else
+#define MOCK(name) name
+#endif
+
+#endif /* TEST_MOCK_H_ */
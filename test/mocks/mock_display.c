@@ -0,0 +1,243 @@
+#include <stdlib.h>
+#include <string.h>
+#include "driver/i2c.h"
+#include "driver/spi_master.h"
+#include "mock.h"
+#include "mock_gpio.h"
+#include "mock_display.h"
+
+#define MOCK_I2C_LINK_MAX 512
+
+// Command link: the bytes written between start and stop
+typedef struct
+{
+    uint8_t data[MOCK_I2C_LINK_MAX];
+    size_t len;
+    bool started;
+    bool stopped;
+} mock_link_t;
+
+static mock_panel_t panel;
+static gpio_num_t dcPin = GPIO_NUM_NC;
+// Argument bytes still expected by the last multi-byte command
+static uint8_t pending;
+static uint8_t pendingCommand;
+
+esp_err_t MOCK(i2c_param_config)(i2c_port_t i2c_num, const i2c_config_t *i2c_conf);
+esp_err_t MOCK(i2c_driver_install)(i2c_port_t i2c_num, i2c_mode_t mode, size_t slv_rx_buf_len,
+                                   size_t slv_tx_buf_len, int intr_alloc_flags);
+i2c_cmd_handle_t MOCK(i2c_cmd_link_create)(void);
+void MOCK(i2c_cmd_link_delete)(i2c_cmd_handle_t cmd_handle);
+esp_err_t MOCK(i2c_master_start)(i2c_cmd_handle_t cmd_handle);
+esp_err_t MOCK(i2c_master_write_byte)(i2c_cmd_handle_t cmd_handle, uint8_t data, bool ack_en);
+esp_err_t MOCK(i2c_master_write)(i2c_cmd_handle_t cmd_handle, const uint8_t *data, size_t data_len, bool ack_en);
+esp_err_t MOCK(i2c_master_stop)(i2c_cmd_handle_t cmd_handle);
+esp_err_t MOCK(i2c_master_cmd_begin)(i2c_port_t i2c_num, i2c_cmd_handle_t cmd_handle, TickType_t ticks_to_wait);
+esp_err_t MOCK(spi_bus_initialize)(spi_host_device_t host_id, const spi_bus_config_t *bus_config,
+                                   spi_dma_chan_t dma_chan);
+esp_err_t MOCK(spi_bus_add_device)(spi_host_device_t host_id, const spi_device_interface_config_t *dev_config,
+                                   spi_device_handle_t *handle);
+esp_err_t MOCK(spi_device_transmit)(spi_device_handle_t handle, spi_transaction_t *trans_desc);
+
+void mock_display_reset(void)
+{
+    memset(&panel, 0, sizeof(panel));
+    panel.contrast = 0x7F;
+    panel.muxRatio = 63;
+    pending = 0;
+}
+
+void mock_display_set_dc(gpio_num_t pin)
+{
+    dcPin = pin;
+}
+
+const mock_panel_t *mock_display_panel(void)
+{
+    return &panel;
+}
+
+int mock_display_ram_page(int line)
+{
+    return (panel.startLine / 8 + line) % SSD1306_RAM_PAGES;
+}
+
+// Bytes following each command that takes arguments (datasheet section 9)
+static uint8_t argument_count(uint8_t command)
+{
+    switch (command)
+    {
+    case OLED_CMD_SET_CONTRAST:
+    case OLED_CMD_SET_MEMORY_ADDR_MODE:
+    case OLED_CMD_SET_MUX_RATIO:
+    case OLED_CMD_SET_DISPLAY_OFFSET:
+    case OLED_CMD_SET_COM_PIN_MAP:
+    case OLED_CMD_SET_DISPLAY_CLK_DIV:
+    case OLED_CMD_SET_PRECHARGE:
+    case OLED_CMD_SET_VCOMH_DESELCT:
+    case OLED_CMD_SET_CHARGE_PUMP:
+        return 1;
+    case OLED_CMD_SET_COLUMN_RANGE:
+    case OLED_CMD_SET_PAGE_RANGE:
+    case OLED_CMD_VERTICAL:
+        return 2;
+    case OLED_CMD_CONTINUOUS_SCROLL:
+    case 0x2A: // vertical and left horizontal scroll
+        return 5;
+    case OLED_CMD_HORIZONTAL_RIGHT:
+    case OLED_CMD_HORIZONTAL_LEFT:
+        return 6;
+    default:
+        return 0;
+    }
+}
+
+static void panel_command(uint8_t byte)
+{
+    if (pending > 0)
+    {
+        if (pendingCommand == OLED_CMD_SET_CONTRAST)
+            panel.contrast = byte;
+        else if (pendingCommand == OLED_CMD_SET_MUX_RATIO)
+            panel.muxRatio = byte & 0x3F;
+        pending--;
+        return;
+    }
+
+    if (byte <= 0x0F)
+        panel.column = (panel.column & 0xF0) | byte;
+    else if (byte <= 0x1F)
+        panel.column = (panel.column & 0x0F) | (byte & 0x0F) << 4;
+    else if (byte >= OLED_CMD_SET_DISPLAY_START_LINE && byte <= 0x7F)
+        panel.startLine = byte & 0x3F;
+    else if (byte >= 0xB0 && byte <= 0xB7)
+        panel.page = byte & 0x07;
+    else if (byte == OLED_CMD_DISPLAY_ON || byte == OLED_CMD_DISPLAY_OFF)
+        panel.on = byte == OLED_CMD_DISPLAY_ON;
+    else if (byte == OLED_CMD_ACTIVE_SCROLL || byte == OLED_CMD_DEACTIVE_SCROLL)
+        panel.scrolling = byte == OLED_CMD_ACTIVE_SCROLL;
+
+    pendingCommand = byte;
+    pending = argument_count(byte);
+}
+
+// Page addressing mode: the column wraps inside the page
+static void panel_data(uint8_t byte)
+{
+    panel.ram[panel.page][panel.column & 0x7F] = byte;
+    panel.column = (panel.column + 1) & 0x7F;
+}
+
+esp_err_t MOCK(i2c_param_config)(i2c_port_t i2c_num, const i2c_config_t *i2c_conf)
+{
+    return ESP_OK;
+}
+
+esp_err_t MOCK(i2c_driver_install)(i2c_port_t i2c_num, i2c_mode_t mode, size_t slv_rx_buf_len,
+                                   size_t slv_tx_buf_len, int intr_alloc_flags)
+{
+    return ESP_OK;
+}
+
+i2c_cmd_handle_t MOCK(i2c_cmd_link_create)(void)
+{
+    return calloc(1, sizeof(mock_link_t));
+}
+
+void MOCK(i2c_cmd_link_delete)(i2c_cmd_handle_t cmd_handle)
+{
+    free(cmd_handle);
+}
+
+esp_err_t MOCK(i2c_master_start)(i2c_cmd_handle_t cmd_handle)
+{
+    mock_link_t *link = cmd_handle;
+    link->started = true;
+    return ESP_OK;
+}
+
+esp_err_t MOCK(i2c_master_write)(i2c_cmd_handle_t cmd_handle, const uint8_t *data, size_t data_len, bool ack_en)
+{
+    mock_link_t *link = cmd_handle;
+    if (!link->started || link->len + data_len > MOCK_I2C_LINK_MAX)
+        return ESP_ERR_INVALID_ARG;
+    memcpy(&link->data[link->len], data, data_len);
+    link->len += data_len;
+    return ESP_OK;
+}
+
+esp_err_t MOCK(i2c_master_write_byte)(i2c_cmd_handle_t cmd_handle, uint8_t data, bool ack_en)
+{
+    return MOCK(i2c_master_write)(cmd_handle, &data, 1, ack_en);
+}
+
+esp_err_t MOCK(i2c_master_stop)(i2c_cmd_handle_t cmd_handle)
+{
+    mock_link_t *link = cmd_handle;
+    link->stopped = true;
+    return ESP_OK;
+}
+
+// Address byte, then control bytes: Co set means one byte follows and then
+// another control byte, D/C# selects data or commands
+esp_err_t MOCK(i2c_master_cmd_begin)(i2c_port_t i2c_num, i2c_cmd_handle_t cmd_handle, TickType_t ticks_to_wait)
+{
+    const mock_link_t *link = cmd_handle;
+    if (!link->started || !link->stopped || link->len == 0)
+        return ESP_ERR_INVALID_ARG;
+    panel.transactions++;
+    panel.bytes += link->len;
+    if (link->data[0] != (I2CAddress << 1 | I2C_MASTER_WRITE))
+    {
+        panel.nacks++;
+        return ESP_FAIL;
+    }
+
+    size_t i = 1;
+    while (i < link->len)
+    {
+        uint8_t control = link->data[i++];
+        bool single = (control & 0x80) != 0;
+        bool data = (control & 0x40) != 0;
+        size_t end = single ? (i + 1 < link->len ? i + 1 : link->len) : link->len;
+        for (; i < end; i++)
+        {
+            if (data)
+                panel_data(link->data[i]);
+            else
+                panel_command(link->data[i]);
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t MOCK(spi_bus_initialize)(spi_host_device_t host_id, const spi_bus_config_t *bus_config,
+                                   spi_dma_chan_t dma_chan)
+{
+    return ESP_OK;
+}
+
+esp_err_t MOCK(spi_bus_add_device)(spi_host_device_t host_id, const spi_device_interface_config_t *dev_config,
+                                   spi_device_handle_t *handle)
+{
+    static int device;
+    *handle = (spi_device_handle_t)&device;
+    return ESP_OK;
+}
+
+esp_err_t MOCK(spi_device_transmit)(spi_device_handle_t handle, spi_transaction_t *trans_desc)
+{
+    const uint8_t *bytes = trans_desc->tx_buffer;
+    size_t len = trans_desc->length / 8;
+    bool data = dcPin != GPIO_NUM_NC && mock_gpio_latch(dcPin) != 0;
+    panel.transactions++;
+    panel.bytes += len;
+    for (size_t i = 0; i < len; i++)
+    {
+        if (data)
+            panel_data(bytes[i]);
+        else
+            panel_command(bytes[i]);
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,38 @@
+#ifndef TEST_MOCK_DISPLAY_H_
+#define TEST_MOCK_DISPLAY_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "driver/gpio.h"
+#include "ssd1306.h"
+
+// SSD1306 behind mocked I2C and SPI master drivers. The real ssd1306
+// transports run unchanged; the bytes they put on the bus are decoded into
+// GDDRAM, start line, contrast and power state, and counted per bus
+// transaction so the component's own counters can be checked.
+
+typedef struct
+{
+    uint8_t ram[SSD1306_RAM_PAGES][128];
+    int page;
+    int column;
+    int startLine;
+    int contrast;
+    bool on;
+    int muxRatio;
+    bool scrolling;
+    // Wire traffic; I2C bytes include the address byte
+    uint32_t transactions;
+    uint32_t bytes;
+    uint32_t nacks; // I2C transactions to another address
+} mock_panel_t;
+
+// Power-on state of the controller, counters cleared
+void mock_display_reset(void);
+// SPI only: the pin that tells commands (low) from data (high)
+void mock_display_set_dc(gpio_num_t pin);
+const mock_panel_t *mock_display_panel(void);
+// GDDRAM page shown on screen line (0..7) for the current start line
+int mock_display_ram_page(int line);
+
+#endif /* TEST_MOCK_DISPLAY_H_ */
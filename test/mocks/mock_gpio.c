@@ -0,0 +1,201 @@
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/gpio.h"
+#include "esp_timer.h"
+#include "esp32/rom/ets_sys.h"
+#include "mock.h"
+#include "mock_gpio.h"
+
+#define MOCK_GPIO_PINS 40
+// The virtual clock starts away from zero: drivers treat 0 as "never"
+#define MOCK_CLOCK_START_US 1000000
+
+typedef struct
+{
+    bool output;
+    bool openDrain;
+    uint32_t latch;
+    const mock_pin_model_t *model;
+} mock_pin_t;
+
+static mock_pin_t pins[MOCK_GPIO_PINS];
+static int attached;
+static int64_t clockUs = MOCK_CLOCK_START_US;
+
+#if MOCK_WRAP
+esp_err_t REAL(gpio_set_direction)(gpio_num_t gpio_num, gpio_mode_t mode);
+esp_err_t REAL(gpio_set_level)(gpio_num_t gpio_num, uint32_t level);
+int REAL(gpio_get_level)(gpio_num_t gpio_num);
+void REAL(ets_delay_us)(uint32_t us);
+int64_t REAL(esp_timer_get_time)(void);
+void REAL(vTaskDelay)(const TickType_t ticks);
+#endif
+
+esp_err_t MOCK(gpio_set_direction)(gpio_num_t gpio_num, gpio_mode_t mode);
+esp_err_t MOCK(gpio_set_level)(gpio_num_t gpio_num, uint32_t level);
+int MOCK(gpio_get_level)(gpio_num_t gpio_num);
+void MOCK(ets_delay_us)(uint32_t us);
+int64_t MOCK(esp_timer_get_time)(void);
+void MOCK(vTaskDelay)(const TickType_t ticks);
+
+// On the target the real clock runs until a model is attached
+static bool virtual_clock(void)
+{
+#if MOCK_WRAP
+    return attached > 0;
+#else
+    return true;
+#endif
+}
+
+static bool modelled(gpio_num_t pin)
+{
+    return pin >= 0 && pin < MOCK_GPIO_PINS && pins[pin].model != NULL;
+}
+
+void mock_gpio_attach(gpio_num_t pin, const mock_pin_model_t *model)
+{
+    if (pins[pin].model == NULL)
+    {
+#if MOCK_WRAP
+        if (attached == 0)
+            clockUs = REAL(esp_timer_get_time)();
+#endif
+        attached++;
+    }
+    pins[pin] = (mock_pin_t){.model = model, .latch = 1};
+}
+
+void mock_gpio_detach(gpio_num_t pin)
+{
+    if (pins[pin].model != NULL)
+        attached--;
+    pins[pin].model = NULL;
+}
+
+mock_pin_drive_t mock_gpio_drive(gpio_num_t pin)
+{
+    const mock_pin_t *p = &pins[pin];
+    if (!p->output)
+        return MOCK_PIN_RELEASED;
+    if (p->latch == 0)
+        return MOCK_PIN_LOW;
+    return p->openDrain ? MOCK_PIN_RELEASED : MOCK_PIN_HIGH;
+}
+
+uint32_t mock_gpio_latch(gpio_num_t pin)
+{
+    return pins[pin].latch;
+}
+
+int64_t mock_clock_now(void)
+{
+    return clockUs;
+}
+
+static void notify(gpio_num_t pin, mock_pin_drive_t before)
+{
+    mock_pin_drive_t after = mock_gpio_drive(pin);
+    if (after != before)
+        pins[pin].model->driven(after);
+}
+
+esp_err_t MOCK(gpio_set_direction)(gpio_num_t gpio_num, gpio_mode_t mode)
+{
+    if (gpio_num < 0 || gpio_num >= MOCK_GPIO_PINS)
+        return ESP_ERR_INVALID_ARG;
+    mock_pin_drive_t before = mock_gpio_drive(gpio_num);
+    pins[gpio_num].output = (mode & GPIO_MODE_DEF_OUTPUT) != 0;
+    pins[gpio_num].openDrain = (mode & GPIO_MODE_DEF_OD) != 0;
+    if (modelled(gpio_num))
+    {
+        notify(gpio_num, before);
+        return ESP_OK;
+    }
+#if MOCK_WRAP
+    return REAL(gpio_set_direction)(gpio_num, mode);
+#else
+    return ESP_OK;
+#endif
+}
+
+esp_err_t MOCK(gpio_set_level)(gpio_num_t gpio_num, uint32_t level)
+{
+    if (gpio_num < 0 || gpio_num >= MOCK_GPIO_PINS)
+        return ESP_ERR_INVALID_ARG;
+    mock_pin_drive_t before = mock_gpio_drive(gpio_num);
+    pins[gpio_num].latch = level != 0;
+    if (modelled(gpio_num))
+    {
+        notify(gpio_num, before);
+        return ESP_OK;
+    }
+#if MOCK_WRAP
+    return REAL(gpio_set_level)(gpio_num, level);
+#else
+    return ESP_OK;
+#endif
+}
+
+int MOCK(gpio_get_level)(gpio_num_t gpio_num)
+{
+    if (modelled(gpio_num))
+    {
+        // Wired AND: the master holding the line low wins over everything
+        if (mock_gpio_drive(gpio_num) == MOCK_PIN_LOW)
+            return 0;
+        return pins[gpio_num].model->sample();
+    }
+#if MOCK_WRAP
+    return REAL(gpio_get_level)(gpio_num);
+#else
+    if (gpio_num < 0 || gpio_num >= MOCK_GPIO_PINS)
+        return 0;
+    return pins[gpio_num].output ? (int)pins[gpio_num].latch : 1;
+#endif
+}
+
+#if !MOCK_WRAP
+esp_err_t gpio_reset_pin(gpio_num_t gpio_num)
+{
+    if (gpio_num < 0 || gpio_num >= MOCK_GPIO_PINS)
+        return ESP_ERR_INVALID_ARG;
+    pins[gpio_num].output = false;
+    pins[gpio_num].openDrain = false;
+    return ESP_OK;
+}
+#endif
+
+void MOCK(ets_delay_us)(uint32_t us)
+{
+    if (virtual_clock())
+    {
+        clockUs += us;
+        return;
+    }
+#if MOCK_WRAP
+    REAL(ets_delay_us)(us);
+#endif
+}
+
+int64_t MOCK(esp_timer_get_time)(void)
+{
+#if MOCK_WRAP
+    if (!virtual_clock())
+        return REAL(esp_timer_get_time)();
+#endif
+    return clockUs;
+}
+
+void MOCK(vTaskDelay)(const TickType_t ticks)
+{
+    if (virtual_clock())
+    {
+        clockUs += (int64_t)ticks * portTICK_PERIOD_MS * 1000;
+        return;
+    }
+#if MOCK_WRAP
+    REAL(vTaskDelay)(ticks);
+#endif
+}
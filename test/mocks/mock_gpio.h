@@ -0,0 +1,33 @@
+#ifndef TEST_MOCK_GPIO_H_
+#define TEST_MOCK_GPIO_H_
+
+#include <stdint.h>
+#include "driver/gpio.h"
+
+// GPIO levels and a virtual clock. A pin model attached to a pin sees every
+// change of what the master drives and answers gpio_get_level. While a
+// model is attached ets_delay_us, vTaskDelay and esp_timer_get_time run on
+// the virtual clock, so bus timing is exact and the tests take no real time.
+
+typedef enum
+{
+    MOCK_PIN_RELEASED, // input or open drain high: the pull-up holds the line
+    MOCK_PIN_LOW,
+    MOCK_PIN_HIGH, // push-pull high, e.g. the 1-Wire strong pull-up
+} mock_pin_drive_t;
+
+typedef struct
+{
+    void (*driven)(mock_pin_drive_t drive); // called after each change
+    int (*sample)(void);                    // level of the released line
+} mock_pin_model_t;
+
+void mock_gpio_attach(gpio_num_t pin, const mock_pin_model_t *model);
+void mock_gpio_detach(gpio_num_t pin);
+mock_pin_drive_t mock_gpio_drive(gpio_num_t pin);
+// Output latch, whether or not the pin is an output (SPI D/C)
+uint32_t mock_gpio_latch(gpio_num_t pin);
+
+int64_t mock_clock_now(void);
+
+#endif /* TEST_MOCK_GPIO_H_ */
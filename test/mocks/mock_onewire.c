@@ -0,0 +1,410 @@
+#include <math.h>
+#include <string.h>
+#include "mock_gpio.h"
+#include "mock_onewire.h"
+
+#define OW_RESET_US 480
+#define OW_ZERO_US 30      // the sensors sample the line this long after the falling edge
+#define OW_SLOT_MAX_US 120 // longer pulses that are not a reset are ignored
+#define OW_PRESENCE_DELAY_US 30
+#define OW_PRESENCE_US 120
+#define OW_HOLD_US 30 // a sensor sending 0 holds the line this long
+
+#define OW_SKIP_ROM 0xCC
+#define OW_MATCH_ROM 0x55
+#define OW_SEARCH 0xF0
+#define OW_ALARM_SEARCH 0xEC
+#define OW_CONVERT 0x44
+#define OW_READ_SCRATCH 0xBE
+#define OW_WRITE_SCRATCH 0x4E
+#define OW_READ_POWER 0xB4
+
+typedef enum
+{
+    OW_IDLE,     // deselected until the next reset
+    OW_ROM,      // receiving the ROM command
+    OW_MATCH,    // receiving the ROM to match
+    OW_SEARCH_ROM, // sending a ROM bit and its complement, receiving the direction
+    OW_FUNCTION, // receiving the function command
+    OW_WRITE,    // receiving TH, TL and configuration
+    OW_READ,     // sending the scratchpad
+    OW_POWER,    // sending the power supply bit
+    OW_CONVERTING,
+} ow_phase_t;
+
+typedef struct
+{
+    uint8_t rom[8];
+    bool parasite;
+    bool corrupt;
+    int16_t measured; // 1/16 C
+    uint8_t scratch[9];
+    uint8_t out[9]; // scratchpad as sent, after corruption
+    bool alarm;
+    bool converting;
+    bool browned;
+    int brownouts;
+    int64_t convertDone;
+    ow_phase_t phase;
+    int bit;
+    uint8_t shift;
+    bool matched;
+    int searchStep;
+    int tx; // bit sent in the current slot, -1 when listening
+} ow_device_t;
+
+static gpio_num_t busPin = GPIO_NUM_NC;
+static ow_device_t devices[MOCK_ONEWIRE_DEVICES];
+static int deviceCount;
+static int64_t lowSince = -1;
+static int64_t slotStart;
+static int64_t presenceFrom;
+static int64_t presenceTo;
+
+uint8_t mock_onewire_crc8(const uint8_t *data, int len)
+{
+    uint8_t crc = 0;
+    for (int i = 0; i < len; i++)
+    {
+        uint8_t byte = data[i];
+        for (int bit = 0; bit < 8; bit++)
+        {
+            uint8_t mix = (crc ^ byte) & 0x01;
+            crc >>= 1;
+            if (mix)
+                crc ^= 0x8C;
+            byte >>= 1;
+        }
+    }
+    return crc;
+}
+
+static int resolution(const ow_device_t *dev)
+{
+    return 9 + ((dev->scratch[4] >> 5) & 0x03);
+}
+
+static void seal(ow_device_t *dev)
+{
+    dev->scratch[8] = mock_onewire_crc8(dev->scratch, 8);
+}
+
+static void store_temperature(ow_device_t *dev, int16_t raw)
+{
+    dev->scratch[0] = raw & 0xFF;
+    dev->scratch[1] = (uint16_t)raw >> 8;
+    seal(dev);
+}
+
+// Conversions finish in the background; the result lands in the
+// scratchpad the first time the bus looks at the sensor afterwards
+static void finish_conversion(ow_device_t *dev, int64_t now)
+{
+    if (!dev->converting || now < dev->convertDone)
+        return;
+    dev->converting = false;
+    if (dev->browned)
+    {
+        // Brown-out during the conversion: the sensor restarts
+        dev->brownouts++;
+        store_temperature(dev, MOCK_DS18B20_POWER_ON_RAW);
+        return;
+    }
+    // Below 12 bits the low bits are undefined; the sensor leaves them set
+    // so a reader that forgets to mask them is caught
+    int undefined = 12 - resolution(dev);
+    int16_t raw = dev->measured & ~((1 << undefined) - 1);
+    raw |= (1 << undefined) - 1;
+    store_temperature(dev, raw);
+    int8_t whole = (int8_t)(dev->measured >> 4);
+    dev->alarm = whole <= (int8_t)dev->scratch[3] || whole >= (int8_t)dev->scratch[2];
+}
+
+static int rom_bit(const ow_device_t *dev, int bit)
+{
+    return (dev->rom[bit / 8] >> (bit % 8)) & 1;
+}
+
+static void enter(ow_device_t *dev, ow_phase_t phase)
+{
+    dev->phase = phase;
+    dev->bit = 0;
+    dev->shift = 0;
+    dev->searchStep = 0;
+}
+
+static int transmit_bit(ow_device_t *dev, int64_t now)
+{
+    switch (dev->phase)
+    {
+    case OW_SEARCH_ROM:
+        if (dev->searchStep == 2)
+            return -1;
+        return rom_bit(dev, dev->bit) ^ dev->searchStep;
+    case OW_READ:
+        if (dev->bit >= 72)
+            return 1;
+        return (dev->out[dev->bit / 8] >> (dev->bit % 8)) & 1;
+    case OW_POWER:
+        return dev->parasite ? 0 : 1;
+    case OW_CONVERTING:
+        // Parasite sensors feed from the line and cannot answer
+        if (dev->parasite)
+            return -1;
+        finish_conversion(dev, now);
+        return dev->converting ? 0 : 1;
+    default:
+        return -1;
+    }
+}
+
+static void sent(ow_device_t *dev)
+{
+    switch (dev->phase)
+    {
+    case OW_SEARCH_ROM:
+        dev->searchStep++;
+        break;
+    case OW_READ:
+        dev->bit++;
+        break;
+    case OW_POWER:
+        enter(dev, OW_IDLE);
+        break;
+    default:
+        break;
+    }
+}
+
+static void rom_command(ow_device_t *dev, uint8_t command)
+{
+    switch (command)
+    {
+    case OW_SKIP_ROM:
+        enter(dev, OW_FUNCTION);
+        break;
+    case OW_MATCH_ROM:
+        enter(dev, OW_MATCH);
+        dev->matched = true;
+        break;
+    case OW_SEARCH:
+        enter(dev, OW_SEARCH_ROM);
+        break;
+    case OW_ALARM_SEARCH:
+        enter(dev, dev->alarm ? OW_SEARCH_ROM : OW_IDLE);
+        break;
+    default:
+        enter(dev, OW_IDLE);
+        break;
+    }
+}
+
+static void function_command(ow_device_t *dev, uint8_t command, int64_t now)
+{
+    switch (command)
+    {
+    case OW_CONVERT:
+        enter(dev, OW_CONVERTING);
+        dev->converting = true;
+        dev->browned = false;
+        dev->convertDone = now + MOCK_DS18B20_CONVERT_US(resolution(dev));
+        break;
+    case OW_READ_SCRATCH:
+        finish_conversion(dev, now);
+        enter(dev, OW_READ);
+        memcpy(dev->out, dev->scratch, sizeof(dev->out));
+        if (dev->corrupt)
+            dev->out[0] ^= 0x01;
+        break;
+    case OW_WRITE_SCRATCH:
+        enter(dev, OW_WRITE);
+        break;
+    case OW_READ_POWER:
+        enter(dev, OW_POWER);
+        break;
+    default:
+        enter(dev, OW_IDLE);
+        break;
+    }
+}
+
+static void received(ow_device_t *dev, int value, int64_t now)
+{
+    switch (dev->phase)
+    {
+    case OW_ROM:
+    case OW_FUNCTION:
+        dev->shift |= value << dev->bit;
+        if (++dev->bit == 8)
+        {
+            if (dev->phase == OW_ROM)
+                rom_command(dev, dev->shift);
+            else
+                function_command(dev, dev->shift, now);
+        }
+        break;
+    case OW_MATCH:
+        dev->matched = dev->matched && value == rom_bit(dev, dev->bit);
+        if (++dev->bit == 64)
+            enter(dev, dev->matched ? OW_FUNCTION : OW_IDLE);
+        break;
+    case OW_SEARCH_ROM:
+        if (value != rom_bit(dev, dev->bit))
+        {
+            enter(dev, OW_IDLE);
+            break;
+        }
+        dev->searchStep = 0;
+        if (++dev->bit == 64)
+            enter(dev, OW_FUNCTION);
+        break;
+    case OW_WRITE:
+    {
+        uint8_t *reg = &dev->scratch[2 + dev->bit / 8];
+        if (dev->bit % 8 == 0)
+            *reg = 0;
+        *reg |= value << (dev->bit % 8);
+        if (++dev->bit == 24)
+        {
+            // Only the resolution bits of the configuration are writable
+            dev->scratch[4] = (dev->scratch[4] & 0x60) | 0x1F;
+            seal(dev);
+            enter(dev, OW_IDLE);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+static void bus_driven(mock_pin_drive_t drive)
+{
+    int64_t now = mock_clock_now();
+    if (drive == MOCK_PIN_LOW && lowSince < 0)
+    {
+        lowSince = now;
+        slotStart = now;
+        for (int i = 0; i < deviceCount; i++)
+            devices[i].tx = transmit_bit(&devices[i], now);
+    }
+    else if (drive != MOCK_PIN_LOW && lowSince >= 0)
+    {
+        int64_t width = now - lowSince;
+        lowSince = -1;
+        if (width >= OW_RESET_US)
+        {
+            for (int i = 0; i < deviceCount; i++)
+            {
+                finish_conversion(&devices[i], now);
+                enter(&devices[i], OW_ROM);
+            }
+            presenceFrom = now + OW_PRESENCE_DELAY_US;
+            presenceTo = presenceFrom + OW_PRESENCE_US;
+        }
+        else if (width < OW_SLOT_MAX_US)
+        {
+            for (int i = 0; i < deviceCount; i++)
+            {
+                if (devices[i].tx >= 0)
+                    sent(&devices[i]);
+                else
+                    received(&devices[i], width < OW_ZERO_US, now);
+            }
+        }
+    }
+
+    // A parasite sensor converting needs the strong pull-up all along
+    if (drive != MOCK_PIN_HIGH)
+    {
+        for (int i = 0; i < deviceCount; i++)
+        {
+            ow_device_t *dev = &devices[i];
+            if (dev->parasite && dev->converting && now < dev->convertDone)
+                dev->browned = true;
+        }
+    }
+}
+
+static int bus_sample(void)
+{
+    int64_t now = mock_clock_now();
+    if (deviceCount > 0 && now >= presenceFrom && now < presenceTo)
+        return 0;
+    for (int i = 0; i < deviceCount; i++)
+    {
+        if (devices[i].tx == 0 && now < slotStart + OW_HOLD_US)
+            return 0;
+    }
+    return 1;
+}
+
+static const mock_pin_model_t busModel = {
+    .driven = bus_driven,
+    .sample = bus_sample,
+};
+
+void mock_onewire_attach(gpio_num_t pin)
+{
+    memset(devices, 0, sizeof(devices));
+    deviceCount = 0;
+    lowSince = -1;
+    presenceFrom = presenceTo = 0;
+    busPin = pin;
+    mock_gpio_attach(pin, &busModel);
+}
+
+void mock_onewire_detach(void)
+{
+    if (busPin != GPIO_NUM_NC)
+        mock_gpio_detach(busPin);
+    busPin = GPIO_NUM_NC;
+}
+
+int mock_onewire_add(uint8_t serial, bool parasite, uint8_t *rom)
+{
+    if (deviceCount == MOCK_ONEWIRE_DEVICES)
+        return -1;
+    ow_device_t *dev = &devices[deviceCount];
+    memset(dev, 0, sizeof(*dev));
+    dev->rom[0] = MOCK_DS18B20_FAMILY;
+    dev->rom[1] = serial;
+    dev->rom[7] = mock_onewire_crc8(dev->rom, 7);
+    dev->parasite = parasite;
+    dev->phase = OW_IDLE;
+    dev->tx = -1;
+    // Power-up scratchpad: 85 C, TH 75, TL 70, 12 bits
+    const uint8_t powerOn[8] = {0x50, 0x05, 75, 70, 0x7F, 0xFF, 0x0C, 0x10};
+    memcpy(dev->scratch, powerOn, sizeof(powerOn));
+    seal(dev);
+    dev->measured = MOCK_DS18B20_POWER_ON_RAW;
+    if (rom != NULL)
+        memcpy(rom, dev->rom, sizeof(dev->rom));
+    return deviceCount++;
+}
+
+void mock_onewire_set_temperature(int device, float celsius)
+{
+    devices[device].measured = (int16_t)floorf(celsius * 16);
+}
+
+void mock_onewire_corrupt(int device, bool corrupt)
+{
+    devices[device].corrupt = corrupt;
+}
+
+uint8_t mock_onewire_config(int device)
+{
+    return devices[device].scratch[4];
+}
+
+bool mock_onewire_alarm(int device)
+{
+    return devices[device].alarm;
+}
+
+int mock_onewire_brownouts(int device)
+{
+    finish_conversion(&devices[device], mock_clock_now());
+    return devices[device].brownouts;
+}
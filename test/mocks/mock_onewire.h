@@ -0,0 +1,39 @@
+#ifndef TEST_MOCK_ONEWIRE_H_
+#define TEST_MOCK_ONEWIRE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "driver/gpio.h"
+
+// DS18B20 sensors on a simulated 1-Wire bus, driven through the mocked GPIO
+// by the real ds18b20 component. Slots are decoded from the length of the
+// master's low pulses on the virtual clock: >= 480 us is a reset, < 30 us
+// a 1 (or a read slot), up to 120 us a 0. The sensors answer reset with a
+// presence pulse and support SKIP/MATCH ROM, SEARCH and ALARM SEARCH,
+// CONVERT T, READ/WRITE SCRATCHPAD and READ POWER SUPPLY.
+
+#define MOCK_ONEWIRE_DEVICES 8
+#define MOCK_DS18B20_FAMILY 0x28
+// Conversion time of the simulated sensor, 80 % of the datasheet maximum
+#define MOCK_DS18B20_CONVERT_US(bits) (75000 << ((bits) - 9))
+// Scratchpad temperature after power-up or a failed parasite conversion
+#define MOCK_DS18B20_POWER_ON_RAW 0x0550
+
+// Starts an empty bus on pin
+void mock_onewire_attach(gpio_num_t pin);
+void mock_onewire_detach(void);
+
+// Adds a sensor with ROM 28 <serial> 00 00 00 00 00 <crc> and returns its
+// index; the ROM is written to rom if not NULL
+int mock_onewire_add(uint8_t serial, bool parasite, uint8_t *rom);
+// Temperature measured by the next conversions
+void mock_onewire_set_temperature(int device, float celsius);
+// Flip one bit of every scratchpad the sensor sends
+void mock_onewire_corrupt(int device, bool corrupt);
+
+uint8_t mock_onewire_config(int device);       // configuration register
+bool mock_onewire_alarm(int device);            // alarm flag of the last conversion
+int mock_onewire_brownouts(int device);         // parasite conversions without the strong pull-up
+uint8_t mock_onewire_crc8(const uint8_t *data, int len);
+
+#endif /* TEST_MOCK_ONEWIRE_H_ */
@@ -0,0 +1,285 @@
+// Decoder for the binary telemetry stream written by main/binlog.c.
+//
+// Usage: telemetry_decoder [-o DIR] [capture.bin | -]
+//
+// Reads a raw UART capture (e.g. `cat /dev/ttyUSB1 > capture.bin`) and writes
+// samples.csv, events.csv and trace.csv to DIR (default: current directory).
+// Frames with a bad CRC or a wrong length are counted and skipped, so a
+// capture may start or end in the middle of a frame.
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "binlog.h"
+
+namespace
+{
+
+uint16_t crc16(const uint8_t *data, size_t len)
+{
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++)
+    {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+    }
+    return crc;
+}
+
+uint16_t u16(const uint8_t *p) { return uint16_t(p[0] | p[1] << 8); }
+uint32_t u32(const uint8_t *p) { return uint32_t(u16(p)) | uint32_t(u16(p + 2)) << 16; }
+
+// Buffered CSV output with to_chars, no iostreams or printf per field
+class CsvWriter
+{
+public:
+    CsvWriter(const std::string &path, const char *header) : file_(std::fopen(path.c_str(), "wb"))
+    {
+        if (file_ == nullptr)
+        {
+            std::perror(path.c_str());
+            return;
+        }
+        text(header);
+        end();
+    }
+    ~CsvWriter()
+    {
+        flush();
+        if (file_ != nullptr)
+            std::fclose(file_);
+    }
+    bool ok() const { return file_ != nullptr; }
+
+    CsvWriter &uint(uint64_t value) { return field([&](char *p, char *e) { return std::to_chars(p, e, value).ptr; }); }
+    CsvWriter &sint(int64_t value) { return field([&](char *p, char *e) { return std::to_chars(p, e, value).ptr; }); }
+    // Fixed point x100 as a decimal with two places
+    CsvWriter &centi(int32_t value)
+    {
+        return field([&](char *p, char *e) {
+            if (value < 0)
+                *p++ = '-';
+            uint32_t magnitude = value < 0 ? uint32_t(-int64_t(value)) : uint32_t(value);
+            p = std::to_chars(p, e, magnitude / 100).ptr;
+            *p++ = '.';
+            *p++ = char('0' + magnitude / 10 % 10);
+            *p++ = char('0' + magnitude % 10);
+            return p;
+        });
+    }
+    CsvWriter &text(const char *value)
+    {
+        return field([&](char *p, char *) {
+            size_t len = std::strlen(value);
+            std::memcpy(p, value, len);
+            return p + len;
+        });
+    }
+    void end()
+    {
+        if (used_ < sizeof(buffer_))
+            buffer_[used_++] = '\n';
+        first_ = true;
+        // Room for a full record before the next check
+        if (used_ > sizeof(buffer_) - 256)
+            flush();
+    }
+
+private:
+    template <typename F> CsvWriter &field(F write)
+    {
+        if (!first_)
+            buffer_[used_++] = ',';
+        first_ = false;
+        used_ = write(buffer_ + used_, buffer_ + sizeof(buffer_)) - buffer_;
+        return *this;
+    }
+    void flush()
+    {
+        if (file_ != nullptr && used_ > 0)
+            std::fwrite(buffer_, 1, used_, file_);
+        used_ = 0;
+    }
+
+    std::FILE *file_;
+    char buffer_[1 << 16];
+    size_t used_ = 0;
+    bool first_ = true;
+};
+
+struct Stats
+{
+    uint64_t frames = 0;
+    uint64_t badCrc = 0;
+    uint64_t badLength = 0;
+    uint64_t unknown = 0;
+};
+
+class Decoder
+{
+public:
+    explicit Decoder(const std::string &dir)
+        : samples_(dir + "/samples.csv", "seq,time_s,tank,level_pct,temperature_c,rate_pct_min,pump,heater,alarms"),
+          events_(dir + "/events.csv", "time_s,tank,event,value,previous"),
+          trace_(dir + "/trace.csv", "core,ts_us,id,arg")
+    {
+    }
+
+    bool ok() const { return samples_.ok() && events_.ok() && trace_.ok(); }
+    const Stats &stats() const { return stats_; }
+
+    void feed(const uint8_t *data, size_t len)
+    {
+        for (size_t i = 0; i < len; i++)
+        {
+            if (data[i] == 0)
+            {
+                if (!overflow_ && !frame_.empty())
+                    frame(frame_.data(), frame_.size());
+                frame_.clear();
+                overflow_ = false;
+            }
+            else if (frame_.size() < BINLOG_FRAME_MAX)
+            {
+                frame_.push_back(data[i]);
+            }
+            else
+            {
+                overflow_ = true;
+            }
+        }
+    }
+
+private:
+    void frame(const uint8_t *cobs, size_t len)
+    {
+        uint8_t raw[BINLOG_FRAME_MAX];
+        size_t rawLen = 0;
+        for (size_t i = 0; i < len;)
+        {
+            uint8_t code = cobs[i++];
+            for (uint8_t j = 1; j < code; j++)
+            {
+                if (i >= len)
+                {
+                    stats_.badLength++;
+                    return;
+                }
+                raw[rawLen++] = cobs[i++];
+            }
+            if (code != 0xFF && i < len)
+                raw[rawLen++] = 0;
+        }
+        if (rawLen < 3 || crc16(raw, rawLen - 2) != u16(&raw[rawLen - 2]))
+        {
+            stats_.badCrc++;
+            return;
+        }
+        stats_.frames++;
+        record(raw[0], &raw[1], rawLen - 3);
+    }
+
+    void record(uint8_t type, const uint8_t *p, size_t len)
+    {
+        switch (type)
+        {
+        case BINLOG_SAMPLE:
+            if (!expect(len, 16))
+                return;
+            samples_.uint(u32(p)).uint(u32(p + 4)).uint(p[14] >> BINLOG_FLAG_TANK_SHIFT)
+                .centi(int16_t(u16(p + 8))).centi(int16_t(u16(p + 10))).centi(int16_t(u16(p + 12)))
+                .uint((p[14] & BINLOG_FLAG_PUMP) != 0).uint((p[14] & BINLOG_FLAG_HEATER) != 0).uint(p[15]);
+            samples_.end();
+            break;
+        case BINLOG_ACTUATOR:
+            if (!expect(len, 7))
+                return;
+            events_.uint(u32(p)).uint(p[4]).text(p[5] == BINLOG_ACTUATOR_PUMP ? "pump" : "heater").uint(p[6]).uint(!p[6]);
+            events_.end();
+            break;
+        case BINLOG_ALARM:
+            if (!expect(len, 7))
+                return;
+            events_.uint(u32(p)).uint(p[4]).text("alarms").uint(p[5]).uint(p[6]);
+            events_.end();
+            break;
+        case BINLOG_LOST:
+            if (!expect(len, 5))
+                return;
+            events_.text("").text("").text(p[0] == BINLOG_SOURCE_HISTORY ? "lost_samples" : "lost_trace").uint(u32(p + 1)).text("");
+            events_.end();
+            break;
+        case BINLOG_TRACE:
+            if (!expect(len, 9))
+                return;
+            trace_.uint(p[0]).uint(u32(p + 1)).uint(u16(p + 5)).uint(u16(p + 7));
+            trace_.end();
+            break;
+        default:
+            stats_.unknown++;
+            break;
+        }
+    }
+
+    bool expect(size_t len, size_t wanted)
+    {
+        if (len == wanted)
+            return true;
+        stats_.badLength++;
+        return false;
+    }
+
+    CsvWriter samples_;
+    CsvWriter events_;
+    CsvWriter trace_;
+    std::vector<uint8_t> frame_;
+    bool overflow_ = false;
+    Stats stats_;
+};
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::string dir = ".";
+    const char *input = "-";
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+            dir = argv[++i];
+        else if (argv[i][0] == '-' && argv[i][1] != '\0')
+        {
+            std::fprintf(stderr, "usage: %s [-o DIR] [capture.bin | -]\n", argv[0]);
+            return 2;
+        }
+        else
+            input = argv[i];
+    }
+
+    std::FILE *in = std::strcmp(input, "-") == 0 ? stdin : std::fopen(input, "rb");
+    if (in == nullptr)
+    {
+        std::perror(input);
+        return 1;
+    }
+
+    Decoder decoder(dir);
+    if (!decoder.ok())
+        return 1;
+    std::vector<uint8_t> buffer(1 << 16);
+    size_t n;
+    while ((n = std::fread(buffer.data(), 1, buffer.size(), in)) > 0)
+        decoder.feed(buffer.data(), n);
+    if (in != stdin)
+        std::fclose(in);
+
+    const Stats &stats = decoder.stats();
+    std::fprintf(stderr, "%llu frames, %llu bad CRC, %llu bad length, %llu unknown type\n",
+                 (unsigned long long)stats.frames, (unsigned long long)stats.badCrc,
+                 (unsigned long long)stats.badLength, (unsigned long long)stats.unknown);
+    return 0;
+}
@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+"""Convert a trace_dump() console capture into Chrome trace / Perfetto JSON.
+
+Usage: trace2json.py monitor.log [-o trace.json]
+
+Open the output in chrome://tracing or https://ui.perfetto.dev.
+Lines that are not part of a dump are ignored, so a raw idf.py monitor
+log can be passed as is. When the log holds several dumps, events seen
+in an earlier dump are not repeated.
+"""
+import argparse
+import json
+import sys
+
+SPAN_END = 0x8000
+POINT = 0x4000
+
+
+def parse(lines):
+    names = {}
+    events = []
+    seen = set()
+    for line in lines:
+        line = line.strip()
+        pos = line.find("TRACE ")
+        if pos < 0:
+            continue
+        fields = line[pos:].split()
+        if len(fields) >= 4 and fields[1] == "NAME":
+            names[int(fields[2], 16)] = fields[3]
+        elif len(fields) == 6 and fields[1] == "EV":
+            core, ts, ev, arg = (int(f, 16) for f in fields[2:])
+            key = (core, ts, ev, arg)
+            if key not in seen:
+                seen.add(key)
+                events.append(key)
+    return names, events
+
+
+def convert(names, events):
+    """Pair each begin with the next end of the same id on the same core and
+    emit complete ("X") events. Spans of different ids interleave on a core
+    (a task and the ISRs that preempt it), so each (core, id) gets its own
+    track; B/E events on one track per core would nest them wrongly."""
+    out = []
+    tracks = set()
+    for core in sorted({e[0] for e in events}):
+        # Timestamps are the low 32 bits of esp_timer_get_time(), unwrap them per core.
+        # Dumps list each ring oldest first, so the log order is the time order.
+        base = 0
+        last = None
+        open_spans = {}
+        for _, ts, ev, arg in (e for e in events if e[0] == core):
+            if last is not None and ts < last and last - ts > 1 << 31:
+                base += 1 << 32
+            last = ts
+            ts += base
+            ident = ev & ~(SPAN_END | POINT)
+            tid = (core << 16) | ident
+            record = {
+                "name": names.get(ident, "event_%d" % ident),
+                "pid": 0,
+                "tid": tid,
+            }
+            if ev & POINT:
+                record.update(ph="i", s="t", ts=ts, args={"arg": arg})
+            elif ev & SPAN_END:
+                # An end whose begin was overwritten in the ring is dropped
+                stack = open_spans.get(ident)
+                if not stack:
+                    continue
+                begin_ts, begin_arg = stack.pop()
+                record.update(ph="X", ts=begin_ts, dur=ts - begin_ts, args={"arg": begin_arg, "end_arg": arg})
+            else:
+                # Begins still open at the end of the dump are dropped
+                open_spans.setdefault(ident, []).append((ts, arg))
+                continue
+            out.append(record)
+            tracks.add((core, ident))
+    for core, ident in sorted(tracks):
+        name = names.get(ident, "event_%d" % ident)
+        out.append({"name": "thread_name", "ph": "M", "pid": 0, "tid": (core << 16) | ident,
+                    "args": {"name": "core %d %s" % (core, name)}})
+        out.append({"name": "thread_sort_index", "ph": "M", "pid": 0, "tid": (core << 16) | ident,
+                    "args": {"sort_index": (core << 16) | ident}})
+    return {"traceEvents": out, "displayTimeUnit": "ms"}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("log")
+    parser.add_argument("-o", "--output", default="-")
+    args = parser.parse_args()
+
+    with open(args.log, errors="replace") as f:
+        names, events = parse(f)
+    trace = convert(names, events)
+    if args.output == "-":
+        json.dump(trace, sys.stdout)
+    else:
+        with open(args.output, "w") as f:
+            json.dump(trace, f)
+    print("%d events" % len(events), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()